@@ -1,21 +1,154 @@
 #include "mir_barrier.h"
 #include "mir_defines.h"
+#include "mir_utils.h"
+#include "mir_task.h"
+#include "mir_team.h"
+#include "mir_worker.h"
 
-void mir_barrier_init(pthread_barrier_t * barrier, int count)
+#include <stdint.h>
+
+// The function mir_barrier_init() builds the combining tree bottom-up.
+// Member i arrives at leaf i / MIR_BARRIER_RADIX, the root comes last.
+
+void mir_barrier_init(struct mir_barrier_t* barrier, int count)
+{ /*{{{*/
+    MIR_ASSERT(count > 0 && count <= MIR_WORKER_MAX_COUNT);
+
+    barrier->count = count;
+    barrier->sense = 0;
+    barrier->num_parked = 0;
+    barrier->num_wakeups = 0;
+    pthread_mutex_init(&barrier->park_lock, NULL);
+    pthread_cond_init(&barrier->park_cond, NULL);
+    for (int i = 0; i < count; i++)
+        barrier->arrived[i] = 0;
+
+    // Each level combines up to MIR_BARRIER_RADIX arrivals of the level below
+    uint32_t level_start = 0;
+    uint32_t arrivals = count;
+    do {
+        uint32_t level_size = (arrivals + MIR_BARRIER_RADIX - 1) / MIR_BARRIER_RADIX;
+        MIR_ASSERT(level_start + level_size <= MIR_WORKER_MAX_COUNT);
+        for (uint32_t i = 0; i < level_size; i++) {
+            struct mir_barrier_node_t* node = &barrier->nodes[level_start + i];
+            uint32_t rest = arrivals - i * MIR_BARRIER_RADIX;
+            node->fan_in = rest < MIR_BARRIER_RADIX ? rest : MIR_BARRIER_RADIX;
+            node->count = node->fan_in;
+            node->parent = NULL;
+        }
+        // Link the level below
+        if (level_start > 0) {
+            uint32_t below_start = level_start - arrivals;
+            for (uint32_t i = 0; i < arrivals; i++)
+                barrier->nodes[below_start + i].parent = &barrier->nodes[level_start + i / MIR_BARRIER_RADIX];
+        }
+        level_start += level_size;
+        arrivals = level_size;
+    } while (arrivals > 1);
+} /*}}}*/
+
+// The function mir_barrier_park() blocks until the episode of the given
+// ... sense is over or the barrier is woken after wakeups was read.
+
+static inline void mir_barrier_park(struct mir_barrier_t* barrier, uint32_t sense, uint32_t wakeups)
+{ /*{{{*/
+    pthread_mutex_lock(&barrier->park_lock);
+    barrier->num_parked++;
+    // The releaser stores the sense before it reads num_parked
+    __sync_synchronize();
+    while (barrier->sense != sense && barrier->num_wakeups == wakeups)
+        pthread_cond_wait(&barrier->park_cond, &barrier->park_lock);
+    barrier->num_parked--;
+    pthread_mutex_unlock(&barrier->park_lock);
+} /*}}}*/
+
+static inline void mir_barrier_unpark(struct mir_barrier_t* barrier)
+{ /*{{{*/
+    // Parking waiters count themselves before they check their condition
+    __sync_synchronize();
+    if (barrier->num_parked > 0) {
+        pthread_mutex_lock(&barrier->park_lock);
+        pthread_cond_broadcast(&barrier->park_cond);
+        pthread_mutex_unlock(&barrier->park_lock);
+    }
+} /*}}}*/
+
+// The function mir_barrier_wake() makes parked members look for tasks again.
+// Used when a task only they can run appears, such as a parallel block
+// ... of a nested team.
+
+void mir_barrier_wake(struct mir_barrier_t* barrier)
 { /*{{{*/
-    pthread_barrier_init(barrier, NULL, count);
+    __sync_fetch_and_add(&barrier->num_wakeups, 1);
+    mir_barrier_unpark(barrier);
 } /*}}}*/
 
-// The function mir_barrier_wait returns 1 to a single worker.
-// How? From the pthread_barrier_wait man page:
-// When the required number of threads have called pthread_barrier_wait() specifying the barrier, the constant PTHREAD_BARRIER_SERIAL_THREAD shall be returned to one unspecified thread and zero shall be returned to each of the remaining threads.
+// The function mir_barrier_wait() returns 1 to a single member, the last
+// ... to arrive, and 0 to the others.
+// Members are the parallel blocks of the team owning the barrier.
 
-int mir_barrier_wait(pthread_barrier_t * barrier)
+int mir_barrier_wait(struct mir_barrier_t* barrier)
 { /*{{{*/
-    if(PTHREAD_BARRIER_SERIAL_THREAD == pthread_barrier_wait(barrier)) {
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    MIR_ASSERT(worker != NULL);
+
+    struct mir_task_t* block = worker->current_task;
+    MIR_ASSERT_STR(block != NULL && block->team != NULL && &block->team->barrier == barrier, "Barriers are waited at only by parallel blocks of their team.");
+    uint32_t member = block - block->team->members;
+    MIR_ASSERT_STR(member < barrier->count, "Task is not a member of a team of %u.", barrier->count);
+
+    uint32_t sense = !barrier->sense;
+    __sync_synchronize();
+
+    // Arrivals are counted per leaf, so an episode must see each member once
+    MIR_ASSERT_STR(barrier->arrived[member] != sense, "Member %u arrived twice at a barrier.", member);
+    barrier->arrived[member] = sense;
+
+    // Arrive at the leaf and combine upwards
+    struct mir_barrier_node_t* node = &barrier->nodes[member / MIR_BARRIER_RADIX];
+    while (__sync_sub_and_fetch(&node->count, 1) == 0) {
+        // Reset for the next episode, no one arrives here before the release
+        node->count = node->fan_in;
+        if (node->parent) {
+            node = node->parent;
+            continue;
+        }
+
+        // Last to arrive, release everybody
+        __sync_synchronize();
+        barrier->sense = sense;
+        mir_barrier_unpark(barrier);
         return 1;
     }
-    else {
-        return 0;
+
+    // Spin briefly
+    for (int i = 0; i < MIR_BARRIER_SPIN_COUNT && barrier->sense != sense; i++)
+        __sync_synchronize();
+
+    // Run pending tasks of the team while waiting, park when there are none
+    // Team tasks descend from the task that started the region.
+    const struct mir_task_t* ancestor = block->parent ? block->parent : block;
+    int idle_rounds = 0;
+    while (barrier->sense != sense) {
+        uint32_t wakeups = barrier->num_wakeups;
+        __sync_synchronize();
+        if (g_num_tasks_waiting > 0 && 1 == mir_worker_help_team(worker, ancestor)) {
+            idle_rounds = 0;
+        }
+        else if (++idle_rounds >= MIR_BARRIER_IDLE_ROUNDS) {
+            idle_rounds = 0;
+            mir_barrier_park(barrier, sense, wakeups);
+        }
     }
+    __sync_synchronize();
+
+    return 0;
+} /*}}}*/
+
+void mir_barrier_destroy(struct mir_barrier_t* barrier)
+{ /*{{{*/
+    MIR_ASSERT(barrier->num_parked == 0);
+
+    pthread_mutex_destroy(&barrier->park_lock);
+    pthread_cond_destroy(&barrier->park_cond);
 } /*}}}*/
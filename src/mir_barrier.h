@@ -2,13 +2,41 @@
 #define MIR_BARRIER_H 1
 
 #include <pthread.h>
+#include <stdint.h>
 
 #include "mir_types.h"
+#include "mir_defines.h"
 
 BEGIN_C_DECLS
 
-void mir_barrier_init(pthread_barrier_t * barrier, int count);
-int mir_barrier_wait(pthread_barrier_t * barrier);
+// A node of the combining tree
+// The last of fan_in arrivals moves up to the parent.
+struct mir_barrier_node_t { /*{{{*/
+    volatile uint32_t count; // Arrivals still expected
+    uint32_t fan_in;
+    struct mir_barrier_node_t* parent;
+}; /*}}}*/
+
+// A sense-reversing combining tree barrier
+// Waiting members spin, then run pending tasks of their team, and park
+// ... only when idle. Members are indexed by their position in the team.
+struct mir_barrier_t { /*{{{*/
+    // A tree over n workers has fewer than n nodes
+    struct mir_barrier_node_t nodes[MIR_WORKER_MAX_COUNT];
+    uint32_t count;
+    // Sense of the episode each member last arrived at
+    uint32_t arrived[MIR_WORKER_MAX_COUNT];
+    volatile uint32_t sense;
+    volatile uint32_t num_parked;
+    volatile uint32_t num_wakeups; // Parked members also wake when this changes
+    pthread_mutex_t park_lock;
+    pthread_cond_t park_cond;
+}; /*}}}*/
+
+void mir_barrier_init(struct mir_barrier_t* barrier, int count);
+int mir_barrier_wait(struct mir_barrier_t* barrier);
+void mir_barrier_wake(struct mir_barrier_t* barrier);
+void mir_barrier_destroy(struct mir_barrier_t* barrier);
 
 END_C_DECLS
 
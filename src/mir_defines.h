@@ -11,11 +11,20 @@
 #define MIR_WORKER_BACKOFF_DURING_SYNC 1
 #define MIR_WORKER_BACKOFF_DURING_BARRIER_WAIT 1
 #define MIR_WORKER_EXPLICIT_BIND
+// Pops between checks of the injection queue for externally submitted tasks
+#define MIR_WORKER_INJECT_POLL_INTERVAL 64
+// Nesting depth of task waits up to which waiting workers execute unrelated tasks
+#define MIR_WORKER_WAIT_DEPTH_LIMIT 32
+// Fruitless searches for descendants beyond the depth limit before a waiting worker takes any task
+#define MIR_WORKER_HELP_MISS_LIMIT 16
+// Default stack size of fibers that waiting tasks leave their workers to
+#define MIR_FIBER_STACK_SIZE (256 * 1024)
 
 // Task
 //#define MIR_TASK_DEBUG
 #define MIR_TASK_DEFAULT_NAME "nameless_task"
 #define MIR_IDLE_TASK_NAME "idle_task"
+#define MIR_TASK_BUNDLE_NAME "task_bundle"
 //#define MIR_TASK_ALLOCATE_ON_STACK
 // Note: Don't change to 0. 0 is reserved for the idle context.
 #define MIR_TASK_ID_START 1
@@ -23,6 +32,48 @@
 #define MIR_TASK_FIXED_DATA_SIZE
 // Uncomment below define statement only if MIR_TASK_FIXED_DATA_SIZE is also defined
 #define MIR_TASK_DATA_MAX_SIZE 256
+// Spins before a non-worker thread blocks on a task handle
+#define MIR_TASK_HANDLE_SPIN_COUNT 1000
+// Buckets (log2) in per-task tables of OpenMP depend clause addresses
+#define MIR_DEP_ADDR_TABLE_BITS 8
+// Task priority levels. Level 0 is handled by the scheduling policy.
+#define MIR_TASK_PRIORITY_LEVELS 4
+// Capacity of each per-worker priority level queue
+#define MIR_TASK_PRIORITY_QUEUE_CAPACITY 4096
+// Entries (log2) in the table of workers that last wrote footprint addresses
+#define MIR_TASK_PRODUCER_TABLE_BITS 12
+// Tasks per worker when a taskloop specifies neither grain size nor number of tasks
+#define MIR_TASKLOOP_TASKS_PER_WORKER 8
+
+// Barrier
+// Arrivals combined at each node of the barrier tree
+#define MIR_BARRIER_RADIX 4
+// Spins before a waiting worker looks for tasks
+#define MIR_BARRIER_SPIN_COUNT 1000
+// Fruitless searches for tasks before a waiting worker parks
+#define MIR_BARRIER_IDLE_ROUNDS 100
+
+// OpenMP lock
+// Spins on a held lock before parking, adapted between the bounds below
+#define MIR_OMP_LOCK_SPIN_COUNT 1000
+#define MIR_OMP_LOCK_SPIN_MIN 100
+#define MIR_OMP_LOCK_SPIN_MAX 10000
+// Locks (log2) that atomic updates without hardware support are striped over
+#define MIR_OMP_ATOMIC_LOCK_BITS 6
+// Atomic stripe locks are padded to this size
+#define MIR_OMP_ATOMIC_LOCK_SIZE 64
+
+// Loop
+// Ranges of the adaptive loop schedule are padded to this size
+#define MIR_LOOP_RANGE_SIZE 64
+// Entries (log2) in the table of recorded affinity loop partitions
+#define MIR_LOOP_AFFINITY_TABLE_BITS 8
+// Affinity loops give each thread at least 1/(this * threads) of the iterations
+#define MIR_LOOP_AFFINITY_MIN_SHARE 8
+// Entries (log2) in the table of parsed precomputed loop schedules
+#define MIR_LOOP_PRECOMP_TABLE_BITS 8
+// Pieces of a footprint whose page placement the numa loop schedule looks up
+#define MIR_LOOP_NUMA_SEGMENTS 64
 
 // Queue
 //#define MIR_QUEUE_DEBUG
@@ -57,6 +108,20 @@
 #define MIR_INLINE_TASK_IF_QUEUE_FULL
 // Creation inline: 0 = never, 1 = always, >1 = inlined if num tasks waiting per worker exceeds
 #define MIR_INLINE_TASK_DURING_CREATION 0
+// Entries (log2) in the table of per-function task granularity statistics
+#define MIR_TASK_GRAN_TABLE_BITS 10
+// Executed tasks of a function measured before it may be inlined
+#define MIR_TASK_GRAN_MIN_SAMPLES 16
+// Tasks running shorter than this many times their overhead are inlined
+#define MIR_TASK_GRAN_OVERHEAD_FACTOR 2
+// Moving averages weigh new samples by 1/2^shift
+#define MIR_TASK_GRAN_EWMA_SHIFT 3
+// One in this many inlining decisions creates a task to keep measuring
+#define MIR_TASK_GRAN_RESAMPLE_INTERVAL 64
+// Most tiny tasks coarsened into one bundle
+#define MIR_TASK_BUNDLE_MAX_SIZE 64
+// Bytes of task data a bundle holds
+#define MIR_TASK_BUNDLE_DATA_SIZE 4096
 
 // Memory allocation policy
 #define MIR_MEM_POL_CACHE_NODES
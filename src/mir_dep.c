@@ -0,0 +1,340 @@
+#include "mir_dep.h"
+#include "mir_task.h"
+#include "mir_worker.h"
+#include "mir_runtime.h"
+#include "mir_memory.h"
+#include "mir_utils.h"
+#include "mir_defines.h"
+#include "scheduling/mir_sched_pol.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+struct mir_dep_domain_t* mir_dep_domain_create()
+{ /*{{{*/
+    struct mir_dep_domain_t* domain = mir_malloc_int(sizeof(struct mir_dep_domain_t));
+    MIR_CHECK_MEM(domain != NULL);
+
+    mir_lock_create(&domain->lock);
+    domain->entries = NULL;
+    domain->addr_table = NULL;
+
+    return domain;
+} /*}}}*/
+
+static inline void mir_dep_entry_list_destroy(struct mir_dep_entry_t* entry)
+{ /*{{{*/
+    while (entry) {
+        struct mir_dep_entry_t* next = entry->next;
+        mir_free_int(entry, sizeof(struct mir_dep_entry_t));
+        entry = next;
+    }
+} /*}}}*/
+
+void mir_dep_domain_reset(struct mir_dep_domain_t* domain)
+{ /*{{{*/
+    MIR_ASSERT(domain != NULL);
+
+    mir_lock_set(&domain->lock);
+
+    mir_dep_entry_list_destroy(domain->entries);
+    domain->entries = NULL;
+
+    if (domain->addr_table) {
+        for (int i = 0; i < (1 << MIR_DEP_ADDR_TABLE_BITS); i++) {
+            struct mir_dep_addr_t* da = domain->addr_table[i];
+            while (da) {
+                struct mir_dep_addr_t* next = da->next;
+                mir_dep_entry_list_destroy(da->readers);
+                mir_free_int(da, sizeof(struct mir_dep_addr_t));
+                da = next;
+            }
+            domain->addr_table[i] = NULL;
+        }
+    }
+
+    mir_lock_unset(&domain->lock);
+} /*}}}*/
+
+void mir_dep_domain_destroy(struct mir_dep_domain_t* domain)
+{ /*{{{*/
+    MIR_ASSERT(domain != NULL);
+
+    mir_dep_domain_reset(domain);
+    if (domain->addr_table)
+        mir_free_int(domain->addr_table, sizeof(struct mir_dep_addr_t*) * (1 << MIR_DEP_ADDR_TABLE_BITS));
+
+    mir_lock_destroy(&domain->lock);
+    mir_free_int(domain, sizeof(struct mir_dep_domain_t));
+} /*}}}*/
+
+struct mir_dep_t* mir_dep_create()
+{ /*{{{*/
+    struct mir_dep_t* dep = mir_malloc_int(sizeof(struct mir_dep_t));
+    MIR_CHECK_MEM(dep != NULL);
+
+    mir_lock_create(&dep->lock);
+    dep->finished = 0;
+    // The creator holds a reference until registration is complete
+    dep->num_pending = 1;
+    dep->succ = NULL;
+
+    return dep;
+} /*}}}*/
+
+// Byte extent covered by a footprint
+// Row-major blocks are approximated by their bounding range.
+static inline void mir_dep_footprint_extent(const struct mir_data_footprint_t* footprint, uintptr_t* lo, uintptr_t* hi)
+{ /*{{{*/
+    uint64_t len = footprint->end - footprint->start + 1;
+    if (footprint->row_sz > 1)
+        len += footprint->end * footprint->row_sz;
+    *lo = (uintptr_t)footprint->base;
+    *hi = *lo + len * footprint->type;
+} /*}}}*/
+
+static int mir_dep_conflict(const struct mir_task_t* a, const struct mir_task_t* b)
+{ /*{{{*/
+    for (int i = 0; i < a->num_data_footprints; i++) {
+        const struct mir_data_footprint_t* fa = &a->data_footprints[i];
+        uintptr_t alo, ahi;
+        mir_dep_footprint_extent(fa, &alo, &ahi);
+        for (int j = 0; j < b->num_data_footprints; j++) {
+            const struct mir_data_footprint_t* fb = &b->data_footprints[j];
+            // Concurrent reads are fine
+            if (fa->data_access != MIR_DATA_ACCESS_WRITE && fb->data_access != MIR_DATA_ACCESS_WRITE)
+                continue;
+            uintptr_t blo, bhi;
+            mir_dep_footprint_extent(fb, &blo, &bhi);
+            if (alo < bhi && blo < ahi)
+                return 1;
+        }
+    }
+
+    return 0;
+} /*}}}*/
+
+int mir_dep_add_edge(struct mir_task_t* pred, struct mir_task_t* succ)
+{ /*{{{*/
+    MIR_ASSERT(pred != NULL && pred->dep != NULL);
+    MIR_ASSERT(succ != NULL && succ->dep != NULL);
+
+    if (pred->dep->finished == 1)
+        return 0;
+
+    int added = 0;
+    mir_lock_set(&pred->dep->lock);
+    if (pred->dep->finished == 0) {
+        struct mir_dep_succ_t* node = mir_malloc_int(sizeof(struct mir_dep_succ_t));
+        MIR_CHECK_MEM(node != NULL);
+        node->task = succ;
+        node->next = pred->dep->succ;
+        pred->dep->succ = node;
+        __sync_fetch_and_add(&succ->dep->num_pending, 1);
+        added = 1;
+    }
+    mir_lock_unset(&pred->dep->lock);
+
+    return added;
+} /*}}}*/
+
+static inline struct mir_dep_domain_t* mir_dep_domain_of(struct mir_task_t* task)
+{ /*{{{*/
+    // Siblings share the domain of their parent
+    if (task->parent) {
+        if (task->parent->dep_domain == NULL)
+            task->parent->dep_domain = mir_dep_domain_create();
+        return task->parent->dep_domain;
+    }
+
+    return runtime->dep_domain;
+} /*}}}*/
+
+int mir_dep_register(struct mir_task_t* task)
+{ /*{{{*/
+    MIR_ASSERT(task != NULL);
+    MIR_ASSERT(task->num_data_footprints > 0);
+
+    struct mir_dep_domain_t* domain = mir_dep_domain_of(task);
+    MIR_ASSERT(domain != NULL);
+
+    if (task->dep == NULL)
+        task->dep = mir_dep_create();
+
+    mir_lock_set(&domain->lock);
+
+    // Depend on conflicting siblings, forget finished ones
+    struct mir_dep_entry_t** link = &domain->entries;
+    while (*link) {
+        struct mir_dep_entry_t* entry = *link;
+        if (entry->task->dep->finished == 1) {
+            *link = entry->next;
+            mir_free_int(entry, sizeof(struct mir_dep_entry_t));
+            continue;
+        }
+        if (mir_dep_conflict(entry->task, task) == 1)
+            mir_dep_add_edge(entry->task, task);
+        link = &entry->next;
+    }
+
+    // Append so that later siblings see this task
+    struct mir_dep_entry_t* entry = mir_malloc_int(sizeof(struct mir_dep_entry_t));
+    MIR_CHECK_MEM(entry != NULL);
+    entry->task = task;
+    entry->next = NULL;
+    *link = entry;
+
+    mir_lock_unset(&domain->lock);
+
+    // Drop creator reference
+    return __sync_sub_and_fetch(&task->dep->num_pending, 1) == 0;
+} /*}}}*/
+
+static inline struct mir_dep_addr_t* mir_dep_addr_lookup(struct mir_dep_domain_t* domain, void* addr)
+{ /*{{{*/
+    // Fibonacci hashing spreads block-aligned addresses
+    uint64_t key = (uint64_t)(uintptr_t)addr * 11400714819323198485ull;
+    struct mir_dep_addr_t** bucket = &domain->addr_table[key >> (64 - MIR_DEP_ADDR_TABLE_BITS)];
+
+    for (struct mir_dep_addr_t* da = *bucket; da; da = da->next)
+        if (da->addr == addr)
+            return da;
+
+    struct mir_dep_addr_t* da = mir_malloc_int(sizeof(struct mir_dep_addr_t));
+    MIR_CHECK_MEM(da != NULL);
+    da->addr = addr;
+    da->last_writer = NULL;
+    da->readers = NULL;
+    da->next = *bucket;
+    *bucket = da;
+
+    return da;
+} /*}}}*/
+
+// The function mir_dep_register_addr() orders the task after earlier
+// ... siblings accessing addr. Called with the domain locked.
+
+static inline void mir_dep_register_addr(struct mir_dep_domain_t* domain, struct mir_task_t* task, void* addr, int out)
+{ /*{{{*/
+    struct mir_dep_addr_t* da = mir_dep_addr_lookup(domain, addr);
+
+    // RAW and WAW
+    if (da->last_writer && da->last_writer != task)
+        mir_dep_add_edge(da->last_writer, task);
+
+    if (out) {
+        // WAR
+        struct mir_dep_entry_t* reader = da->readers;
+        while (reader) {
+            struct mir_dep_entry_t* next = reader->next;
+            if (reader->task != task)
+                mir_dep_add_edge(reader->task, task);
+            mir_free_int(reader, sizeof(struct mir_dep_entry_t));
+            reader = next;
+        }
+        da->readers = NULL;
+        da->last_writer = task;
+    }
+    else if (da->last_writer != task) {
+        // Forget finished readers
+        struct mir_dep_entry_t** link = &da->readers;
+        while (*link) {
+            struct mir_dep_entry_t* reader = *link;
+            if (reader->task->dep->finished == 1) {
+                *link = reader->next;
+                mir_free_int(reader, sizeof(struct mir_dep_entry_t));
+                continue;
+            }
+            link = &reader->next;
+        }
+
+        struct mir_dep_entry_t* reader = mir_malloc_int(sizeof(struct mir_dep_entry_t));
+        MIR_CHECK_MEM(reader != NULL);
+        reader->task = task;
+        reader->next = NULL;
+        *link = reader;
+    }
+} /*}}}*/
+
+int mir_dep_register_depend(struct mir_task_t* task, void** depend)
+{ /*{{{*/
+    MIR_ASSERT(task != NULL);
+    MIR_ASSERT(depend != NULL);
+
+    // libgomp layouts, addresses with outs first
+    // Before GCC 9: number of addresses, number of out/inout addresses, then addresses.
+    // Since GCC 9: 0, number of addresses, numbers of out/inout,
+    // ... mutexinoutset and in addresses, then addresses followed by
+    // ... pointers to depend objects holding an address and a kind.
+    // Mutexinoutset is ordered like inout, which is stricter than needed.
+    uintptr_t num_deps, num_outs, num_direct, offset;
+    if (depend[0] != 0) {
+        num_deps = (uintptr_t)depend[0];
+        num_outs = (uintptr_t)depend[1];
+        num_direct = num_deps;
+        offset = 2;
+    }
+    else {
+        num_deps = (uintptr_t)depend[1];
+        num_outs = (uintptr_t)depend[2] + (uintptr_t)depend[3];
+        num_direct = num_outs + (uintptr_t)depend[4];
+        offset = 5;
+    }
+    MIR_ASSERT(num_outs <= num_direct && num_direct <= num_deps);
+
+    struct mir_dep_domain_t* domain = mir_dep_domain_of(task);
+    MIR_ASSERT(domain != NULL);
+
+    if (task->dep == NULL)
+        task->dep = mir_dep_create();
+
+    mir_lock_set(&domain->lock);
+
+    if (domain->addr_table == NULL) {
+        domain->addr_table = mir_malloc_int(sizeof(struct mir_dep_addr_t*) * (1 << MIR_DEP_ADDR_TABLE_BITS));
+        MIR_CHECK_MEM(domain->addr_table != NULL);
+        for (int i = 0; i < (1 << MIR_DEP_ADDR_TABLE_BITS); i++)
+            domain->addr_table[i] = NULL;
+    }
+
+    for (uintptr_t i = 0; i < num_deps; i++) {
+        if (i < num_direct) {
+            mir_dep_register_addr(domain, task, depend[i + offset], i < num_outs);
+        }
+        else {
+            // Kinds other than in order like inout
+            void** obj = (void**)depend[i + offset];
+            mir_dep_register_addr(domain, task, obj[0], (uintptr_t)obj[1] != MIR_DEP_GOMP_DEPEND_IN);
+        }
+    }
+
+    mir_lock_unset(&domain->lock);
+
+    // Drop creator reference
+    return __sync_sub_and_fetch(&task->dep->num_pending, 1) == 0;
+} /*}}}*/
+
+void mir_dep_release(struct mir_worker_t* worker, struct mir_task_t* task)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+    MIR_ASSERT(task != NULL && task->dep != NULL);
+
+    // Finish and detach successors
+    mir_lock_set(&task->dep->lock);
+    task->dep->finished = 1;
+    struct mir_dep_succ_t* node = task->dep->succ;
+    task->dep->succ = NULL;
+    mir_lock_unset(&task->dep->lock);
+
+    // Schedule successors that became ready
+    while (node) {
+        struct mir_dep_succ_t* next = node->next;
+        struct mir_task_t* succ = node->task;
+        if (__sync_sub_and_fetch(&succ->dep->num_pending, 1) == 0) {
+            T_DBG("Rl", succ);
+            mir_worker_schedule(worker, succ);
+        }
+        mir_free_int(node, sizeof(struct mir_dep_succ_t));
+        node = next;
+    }
+} /*}}}*/
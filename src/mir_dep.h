@@ -0,0 +1,70 @@
+#ifndef MIR_DEP_H
+#define MIR_DEP_H 1
+
+#include <stdint.h>
+
+#include "mir_types.h"
+#include "mir_lock.h"
+
+BEGIN_C_DECLS
+
+struct mir_task_t;
+struct mir_worker_t;
+
+// Successor of a task
+struct mir_dep_succ_t { /*{{{*/
+    struct mir_task_t* task;
+    struct mir_dep_succ_t* next;
+}; /*}}}*/
+
+// Dependence state of a task
+struct mir_dep_t { /*{{{*/
+    struct mir_lock_t lock;
+    uint32_t finished;
+    uint32_t num_pending; // Unfinished predecessors
+    struct mir_dep_succ_t* succ;
+}; /*}}}*/
+
+// In-flight sibling task with a data footprint
+struct mir_dep_entry_t { /*{{{*/
+    struct mir_task_t* task;
+    struct mir_dep_entry_t* next;
+}; /*}}}*/
+
+// Accesses to an address named in an OpenMP depend clause
+struct mir_dep_addr_t { /*{{{*/
+    void* addr;
+    struct mir_task_t* last_writer;
+    struct mir_dep_entry_t* readers; // Since last writer
+    struct mir_dep_addr_t* next;
+}; /*}}}*/
+
+// Sibling tasks among which dependences are resolved
+struct mir_dep_domain_t { /*{{{*/
+    struct mir_lock_t lock;
+    struct mir_dep_entry_t* entries;
+    struct mir_dep_addr_t** addr_table; // Allocated on first use
+}; /*}}}*/
+
+struct mir_dep_domain_t* mir_dep_domain_create();
+
+void mir_dep_domain_destroy(struct mir_dep_domain_t* domain);
+
+void mir_dep_domain_reset(struct mir_dep_domain_t* domain);
+
+struct mir_dep_t* mir_dep_create();
+
+int mir_dep_add_edge(struct mir_task_t* pred, struct mir_task_t* succ);
+
+int mir_dep_register(struct mir_task_t* task);
+
+// Kind of an in dependence in libgomp depend objects
+#define MIR_DEP_GOMP_DEPEND_IN 1
+
+int mir_dep_register_depend(struct mir_task_t* task, void** depend);
+
+void mir_dep_release(struct mir_worker_t* worker, struct mir_task_t* task);
+
+END_C_DECLS
+
+#endif
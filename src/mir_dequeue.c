@@ -320,3 +320,41 @@ pushWSDeque(WSDeque* q, void* elem)
     ASSERT_WSDEQUE_INVARIANTS(q);
     return rtsTrue;
 } /*}}}*/
+
+/* enqueue several elements. Thieves see none of them until bottom
+   is published, so one write barrier covers the whole batch. */
+nat
+pushManyWSDeque(WSDeque* q, void** elems, nat n)
+{ /*{{{*/
+    StgWord t;
+    StgWord b;
+    StgWord sz = q->moduloSize;
+    StgInt room;
+    nat i;
+
+    ASSERT_WSDEQUE_INVARIANTS(q);
+
+    /* as in pushWSDeque, consult the real top only if topBound
+       suggests there is not enough space */
+    b = q->bottom;
+    t = q->topBound;
+    room = (StgInt)sz - ((StgInt)b - (StgInt)t);
+    if (room < (StgInt)n) {
+        t = q->top;
+        q->topBound = t;
+        room = (StgInt)sz - ((StgInt)b - (StgInt)t);
+        if (room < 0)
+            room = 0;
+        if (room < (StgInt)n)
+            n = (nat)room;
+    }
+
+    for (i = 0; i < n; i++)
+        q->elements[(b + i) & sz] = elems[i];
+
+    write_barrier();
+    q->bottom = b + n;
+
+    ASSERT_WSDEQUE_INVARIANTS(q);
+    return n;
+} /*}}}*/
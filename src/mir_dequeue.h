@@ -386,6 +386,11 @@ void* popWSDeque(WSDeque* q);
 // succeeded, or false if the deque is full.
 rtsBool pushWSDeque(WSDeque* q, void* elem);
 
+// Push several elements onto the "write" end of the pool with a
+// single update of bottom.  Returns the number of elements pushed,
+// which is less than n if the deque fills up.
+nat pushManyWSDeque(WSDeque* q, void** elems, nat n);
+
 // Removes all elements from the deque
 EXTERN_INLINE void discardElements(WSDeque* q);
 
@@ -0,0 +1,216 @@
+#include "mir_fiber.h"
+#include "mir_task.h"
+#include "mir_worker.h"
+#include "mir_runtime.h"
+#include "mir_memory.h"
+#include "mir_utils.h"
+#include "mir_defines.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+static inline void mir_fiber_free(struct mir_fiber_t* fiber)
+{ /*{{{*/
+    if (fiber->stack)
+        mir_free_int(fiber->stack, fiber->stack_size);
+    mir_free_int(fiber, sizeof(struct mir_fiber_t));
+} /*}}}*/
+
+static inline void mir_fiber_free_list(struct mir_fiber_t* fiber)
+{ /*{{{*/
+    while (fiber) {
+        struct mir_fiber_t* next = fiber->next;
+        mir_fiber_free(fiber);
+        fiber = next;
+    }
+} /*}}}*/
+
+// The function mir_fiber_pool_destroy() releases the contexts of all workers.
+// Workers have stopped on the stacks of their threads.
+
+void mir_fiber_pool_destroy()
+{ /*{{{*/
+    for (int i = 0; i < runtime->num_workers; i++) {
+        struct mir_worker_t* worker = &runtime->workers[i];
+        MIR_ASSERT(worker->fibers_suspended == NULL);
+        MIR_ASSERT(worker->fibers_idle == NULL);
+        MIR_ASSERT(worker->fiber == NULL || worker->fiber->stack == NULL);
+
+        if (worker->fiber)
+            mir_fiber_free(worker->fiber);
+        mir_fiber_free_list(worker->fibers_free);
+        worker->fiber = NULL;
+        worker->fibers_free = NULL;
+    }
+} /*}}}*/
+
+// The function mir_fiber_current() returns the context the worker runs on.
+// The context of the worker thread stack is created when first needed.
+
+static inline struct mir_fiber_t* mir_fiber_current(struct mir_worker_t* worker)
+{ /*{{{*/
+    if (worker->fiber == NULL) {
+        struct mir_fiber_t* fiber = mir_malloc_int(sizeof(struct mir_fiber_t));
+        MIR_CHECK_MEM(fiber != NULL);
+        fiber->stack = NULL;
+        fiber->stack_size = 0;
+        fiber->next = NULL;
+        worker->fiber = fiber;
+    }
+
+    return worker->fiber;
+} /*}}}*/
+
+// The function mir_fiber_switch() saves the worker state in from
+// ... and continues with the state saved in to.
+// Contexts never leave their worker, so the worker is the same on return.
+
+static void mir_fiber_switch(struct mir_worker_t* worker, struct mir_fiber_t* from, struct mir_fiber_t* to)
+{ /*{{{*/
+    uint64_t now = mir_get_cycles();
+
+    from->current_task = worker->current_task;
+    from->wait_depth = worker->wait_depth;
+    if (from->current_task)
+        from->current_task->exec_cycles += (now - from->current_task->exec_resume_instant);
+
+    worker->fiber = to;
+    worker->current_task = to->current_task;
+    worker->wait_depth = to->wait_depth;
+    if (worker->current_task)
+        worker->current_task->exec_resume_instant = now;
+
+    int rval = swapcontext(&from->ctx, &to->ctx);
+    MIR_ASSERT_STR(rval == 0, "Call to swapcontext failed.");
+} /*}}}*/
+
+// The function mir_fiber_yield() hands the worker back to a context that
+// ... lent it to another. Called where no task is in progress on the
+// ... current context, so a new stack is free for reuse.
+// Returns 0 if no context waits for the worker.
+
+int mir_fiber_yield(struct mir_worker_t* worker)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+
+    struct mir_fiber_t* idle = worker->fibers_idle;
+    if (idle == NULL)
+        return 0;
+    worker->fibers_idle = idle->next;
+
+    struct mir_fiber_t* fiber = mir_fiber_current(worker);
+    if (fiber->stack) {
+        fiber->next = worker->fibers_free;
+        worker->fibers_free = fiber;
+    }
+    else {
+        fiber->next = worker->fibers_idle;
+        worker->fibers_idle = fiber;
+    }
+
+    mir_fiber_switch(worker, fiber, idle);
+
+    return 1;
+} /*}}}*/
+
+// The function mir_fiber_loop() runs on new stacks and looks for work
+// ... like the worker thread until a context lent the worker is free.
+
+static void mir_fiber_loop()
+{ /*{{{*/
+    struct mir_worker_t* worker = mir_worker_get_context();
+
+    // A yielded stack is never switched back to, it is started afresh
+    while (1)
+        if (0 == mir_fiber_yield(worker))
+            mir_worker_do_work(worker, 1);
+} /*}}}*/
+
+// The function mir_fiber_start() sets up a context running mir_fiber_loop()
+// ... on a free stack of the worker or on a new one.
+
+static struct mir_fiber_t* mir_fiber_start(struct mir_worker_t* worker)
+{ /*{{{*/
+    struct mir_fiber_t* fiber = worker->fibers_free;
+    if (fiber) {
+        worker->fibers_free = fiber->next;
+    }
+    else {
+        fiber = mir_malloc_int(sizeof(struct mir_fiber_t));
+        MIR_CHECK_MEM(fiber != NULL);
+        fiber->stack_size = runtime->fiber_stack_size;
+        fiber->stack = mir_malloc_int(fiber->stack_size);
+        MIR_CHECK_MEM(fiber->stack != NULL);
+    }
+    fiber->next = NULL;
+    fiber->current_task = NULL;
+    fiber->wait_depth = 0;
+
+    int rval = getcontext(&fiber->ctx);
+    MIR_ASSERT_STR(rval == 0, "Call to getcontext failed.");
+    fiber->ctx.uc_stack.ss_sp = fiber->stack;
+    fiber->ctx.uc_stack.ss_size = fiber->stack_size;
+    fiber->ctx.uc_link = NULL;
+    makecontext(&fiber->ctx, mir_fiber_loop, 0);
+
+    return fiber;
+} /*}}}*/
+
+// The function mir_fiber_suspend() parks the context of this worker
+// ... until cond(cond_arg) holds. The worker continues on a context
+// ... that lent it to another, or on a new stack.
+
+void mir_fiber_suspend(struct mir_worker_t* worker, mir_fiber_cond_t cond, void* cond_arg)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+    MIR_ASSERT(cond != NULL);
+
+    struct mir_fiber_t* fiber = mir_fiber_current(worker);
+    fiber->cond = cond;
+    fiber->cond_arg = cond_arg;
+    fiber->next = worker->fibers_suspended;
+    worker->fibers_suspended = fiber;
+
+    struct mir_fiber_t* next = worker->fibers_idle;
+    if (next)
+        worker->fibers_idle = next->next;
+    else
+        next = mir_fiber_start(worker);
+
+    mir_fiber_switch(worker, fiber, next);
+} /*}}}*/
+
+// The function mir_fiber_resume_ready() resumes a context suspended by
+// ... this worker whose condition holds. The current context is set aside
+// ... until the worker is free again, or reused if it only looks for work.
+// Returns 0 if there is none.
+
+int mir_fiber_resume_ready(struct mir_worker_t* worker)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+
+    struct mir_fiber_t** prev = &worker->fibers_suspended;
+    struct mir_fiber_t* ready;
+    for (ready = *prev; ready; prev = &ready->next, ready = ready->next)
+        if (ready->cond(ready->cond_arg) == 1)
+            break;
+
+    if (ready == NULL)
+        return 0;
+    *prev = ready->next;
+
+    struct mir_fiber_t* fiber = mir_fiber_current(worker);
+    if (fiber->stack && worker->current_task == NULL) {
+        fiber->next = worker->fibers_free;
+        worker->fibers_free = fiber;
+    }
+    else {
+        fiber->next = worker->fibers_idle;
+        worker->fibers_idle = fiber;
+    }
+
+    mir_fiber_switch(worker, fiber, ready);
+
+    return 1;
+} /*}}}*/
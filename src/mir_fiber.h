@@ -0,0 +1,45 @@
+#ifndef MIR_FIBER_H
+#define MIR_FIBER_H 1
+
+#include <stdint.h>
+#include <ucontext.h>
+
+#include "mir_types.h"
+
+BEGIN_C_DECLS
+
+struct mir_task_t;
+struct mir_worker_t;
+
+// Condition a suspended context waits for
+typedef int (*mir_fiber_cond_t)(void*);
+
+// An execution context of a worker
+// Tasks run on the stack of the worker. A waiting task suspends the
+// ... context it runs on and the worker continues on another context,
+// ... taking a new stack only then. The worker that suspended a context
+// ... resumes it once the condition holds.
+struct mir_fiber_t { /*{{{*/
+    ucontext_t ctx;
+    void* stack; // NULL for the stack of the worker thread
+    size_t stack_size;
+    // Worker state while switched out
+    struct mir_task_t* current_task;
+    uint32_t wait_depth;
+    // Condition waited for when suspended
+    mir_fiber_cond_t cond;
+    void* cond_arg;
+    struct mir_fiber_t* next;
+}; /*}}}*/
+
+void mir_fiber_pool_destroy();
+
+void mir_fiber_suspend(struct mir_worker_t* worker, mir_fiber_cond_t cond, void* cond_arg);
+
+int mir_fiber_resume_ready(struct mir_worker_t* worker);
+
+int mir_fiber_yield(struct mir_worker_t* worker);
+
+END_C_DECLS
+
+#endif
@@ -1,4 +1,8 @@
+#include <limits.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 
 #include "mir_memory.h"
 #include "mir_loop.h"
@@ -7,6 +11,9 @@
 #include "mir_defines.h"
 #include "mir_runtime.h"
 #include "mir_worker.h"
+#include "mir_task.h"
+#include "mir_mem_pol.h"
+#include "arch/mir_arch.h"
 
 struct mir_loop_des_t* mir_new_omp_loop_desc()
 { /*{{{*/
@@ -18,6 +25,159 @@ struct mir_loop_des_t* mir_new_omp_loop_desc()
     return loop;
 } /*}}}*/
 
+#ifdef MIR_GPL
+// Precomputed schedule of a loop instance, parsed once
+struct mir_loop_precomp_t { /*{{{*/
+    unsigned long func;
+    unsigned long idle_join;
+    bool exists; // A schedule file was found
+    // Chunks of each cpu, contiguous and linked in file order reversed
+    struct mir_loop_schedule_t* chunks[MIR_WORKER_MAX_COUNT + 1];
+    struct mir_loop_schedule_t* block;
+    size_t num_chunks;
+    struct mir_loop_precomp_t* next;
+}; /*}}}*/
+
+static struct mir_loop_precomp_t* volatile g_loop_precomp[1 << MIR_LOOP_PRECOMP_TABLE_BITS];
+static struct mir_lock_t g_loop_precomp_lock = { MIR_LOCK_INITIALIZER };
+
+// The function mir_omp_loop_precomp_read() reads the next chunk line of a
+// ... schedule file, skipping malformed lines. Returns false at the end.
+
+static bool mir_omp_loop_precomp_read(FILE* fp, const char* file_name, unsigned long* chunk_start, unsigned long* chunk_end, unsigned long* cpu_id)
+{ /*{{{*/
+    unsigned long work_cycles;
+    while (!feof(fp)) {
+        int retval = fscanf(fp, "%lu,%lu,%lu,%lu\n", chunk_start, chunk_end, cpu_id, &work_cycles);
+        if (retval == 4) {
+            if (*cpu_id == MIR_IMPOSSIBLE_CPU_ID) {
+                MIR_LOG_ERR("Precomputed schedule in file %s uses unsupported MIR_IMPOSSIBLE_CPU_ID.",
+                            file_name);
+            }
+            else if (*cpu_id > runtime->num_workers) {
+                MIR_LOG_ERR("Precomputed schedule in file %s has more workers than available.",
+                            file_name);
+            }
+            return true;
+        }
+        if (ferror(fp)) {
+            MIR_LOG_ERR("Error occured while reading precomputed schedule file: %s.",
+                        file_name);
+        }
+        else if (retval != EOF) {
+            // Skip over.
+            retval = fscanf(fp, "%*[^\n]");
+        }
+    }
+
+    return false;
+} /*}}}*/
+
+// The function mir_omp_loop_precomp_parse() reads the schedule file of a loop
+// ... instance into per-cpu arrays. Missing files are remembered as well.
+
+static struct mir_loop_precomp_t* mir_omp_loop_precomp_parse(unsigned long func, unsigned long idle_join)
+{ /*{{{*/
+    struct mir_loop_precomp_t* precomp = mir_malloc_int(sizeof(struct mir_loop_precomp_t));
+    MIR_CHECK_MEM(precomp != NULL);
+    precomp->func = func;
+    precomp->idle_join = idle_join;
+    precomp->exists = false;
+    precomp->block = NULL;
+    precomp->num_chunks = 0;
+    for (int i = 0; i <= MIR_WORKER_MAX_COUNT; i++)
+        precomp->chunks[i] = NULL;
+
+    char schedule_file_name[MIR_LONG_NAME_LEN + MIR_SHORT_NAME_LEN];
+    sprintf(schedule_file_name, "%s/loop_%lu_%lu.schedule_opt",
+            runtime->precomp_schedule_dir, func, idle_join);
+
+    FILE* fp = fopen(schedule_file_name, "r");
+    if (fp == NULL)
+        return precomp;
+    precomp->exists = true;
+    MIR_LOG_INFO("Using precomputed schedule file: %s.", schedule_file_name);
+
+    // Count chunks of each cpu
+    unsigned long chunk_start, chunk_end, cpu_id;
+    size_t counts[MIR_WORKER_MAX_COUNT + 1] = { 0 };
+    while (mir_omp_loop_precomp_read(fp, schedule_file_name, &chunk_start, &chunk_end, &cpu_id))
+        if (cpu_id <= MIR_WORKER_MAX_COUNT)
+            counts[cpu_id]++;
+
+    size_t ends[MIR_WORKER_MAX_COUNT + 1];
+    for (int i = 0; i <= MIR_WORKER_MAX_COUNT; i++) {
+        precomp->num_chunks += counts[i];
+        ends[i] = precomp->num_chunks;
+    }
+    if (precomp->num_chunks == 0) {
+        fclose(fp);
+        return precomp;
+    }
+    precomp->block = mir_malloc_int(precomp->num_chunks * sizeof(struct mir_loop_schedule_t));
+    MIR_CHECK_MEM(precomp->block != NULL);
+
+    // Fill each cpu's array from the back, later lines come first
+    rewind(fp);
+    while (mir_omp_loop_precomp_read(fp, schedule_file_name, &chunk_start, &chunk_end, &cpu_id)) {
+        if (cpu_id > MIR_WORKER_MAX_COUNT)
+            continue;
+        size_t k = --ends[cpu_id];
+        precomp->block[k].chunk_start = chunk_start;
+        precomp->block[k].chunk_end = chunk_end;
+        precomp->block[k].next = precomp->chunks[cpu_id];
+        precomp->chunks[cpu_id] = &precomp->block[k];
+    }
+    fclose(fp);
+
+    return precomp;
+} /*}}}*/
+
+// The function mir_omp_loop_precomp_get() returns the precomputed schedule
+// ... of a loop instance. Files are parsed on first use only.
+
+static struct mir_loop_precomp_t* mir_omp_loop_precomp_get(unsigned long func, unsigned long idle_join)
+{ /*{{{*/
+    uint64_t key = ((uint64_t)func ^ (uint64_t)idle_join * 0x9E3779B97F4A7C15ULL) * 0x9E3779B97F4A7C15ULL;
+    unsigned slot = key >> (64 - MIR_LOOP_PRECOMP_TABLE_BITS);
+
+    // Entries are published complete and never removed while workers run
+    struct mir_loop_precomp_t* precomp;
+    for (precomp = g_loop_precomp[slot]; precomp; precomp = precomp->next)
+        if (precomp->func == func && precomp->idle_join == idle_join)
+            return precomp;
+
+    mir_lock_set(&g_loop_precomp_lock);
+    for (precomp = g_loop_precomp[slot]; precomp; precomp = precomp->next)
+        if (precomp->func == func && precomp->idle_join == idle_join)
+            break;
+    if (precomp == NULL) {
+        precomp = mir_omp_loop_precomp_parse(func, idle_join);
+        precomp->next = g_loop_precomp[slot];
+        __sync_synchronize();
+        g_loop_precomp[slot] = precomp;
+    }
+    mir_lock_unset(&g_loop_precomp_lock);
+
+    return precomp;
+} /*}}}*/
+#endif
+
+void mir_omp_loop_precomp_destroy()
+{ /*{{{*/
+#ifdef MIR_GPL
+    for (int slot = 0; slot < (1 << MIR_LOOP_PRECOMP_TABLE_BITS); slot++) {
+        while (g_loop_precomp[slot]) {
+            struct mir_loop_precomp_t* precomp = g_loop_precomp[slot];
+            g_loop_precomp[slot] = precomp->next;
+            if (precomp->block)
+                mir_free_int(precomp->block, precomp->num_chunks * sizeof(struct mir_loop_schedule_t));
+            mir_free_int(precomp, sizeof(struct mir_loop_precomp_t));
+        }
+    }
+#endif
+} /*}}}*/
+
 void mir_omp_loop_desc_init(struct mir_loop_des_t* loop, long start, long end,
                             long incr, long chunk_size, bool use_precomp_schedule)
 { /*{{{*/
@@ -26,9 +186,24 @@ void mir_omp_loop_desc_init(struct mir_loop_des_t* loop, long start, long end,
     loop->end = ((incr > 0 && start > end) || (incr < 0 && start < end)) ? start : end;
     loop->chunk_size = chunk_size;
     loop->static_trip = 0;
+
+    // Each worker overshoots end by at most one chunk
+    loop->next_fetch_add = 0;
+    if (chunk_size > 0) {
+        long limit = (incr > 0 ? LONG_MAX : LONG_MIN) / (MIR_WORKER_MAX_COUNT + 1);
+        if (incr > 0 && chunk_size <= limit / incr && loop->end <= LONG_MAX - (MIR_WORKER_MAX_COUNT + 1) * chunk_size * incr)
+            loop->next_fetch_add = 1;
+        else if (incr < 0 && chunk_size <= limit / incr && loop->end >= LONG_MIN - (MIR_WORKER_MAX_COUNT + 1) * chunk_size * incr)
+            loop->next_fetch_add = 1;
+    }
     loop->non_parallel_start = 0;
     loop->precomp_schedule = NULL;
     loop->precomp_schedule_exists = false;
+    loop->first = start;
+    loop->num_iterations = 0;
+    loop->num_ranges = 0;
+    loop->ranges = NULL;
+    loop->affinity = NULL;
     loop->init = 1;
 
     if (!use_precomp_schedule) {
@@ -46,69 +221,605 @@ void mir_omp_loop_desc_init(struct mir_loop_des_t* loop, long start, long end,
 #ifdef MIR_GPL
     unsigned long idle_join = (strcmp(worker->current_task->parent->name, "idle_task") == 0) ? worker->current_task->twc->num_passes : worker->current_task->parent->twc->num_passes;
 
-    char schedule_file_name[MIR_LONG_NAME_LEN + MIR_SHORT_NAME_LEN];
-    char task_of[MIR_SHORT_NAME_LEN];
-    sprintf(task_of, "%p", worker->current_task->func);
-    sprintf(schedule_file_name, "%s/loop_%lu_%lu.schedule_opt",
-            runtime->precomp_schedule_dir,
-            strtol(task_of, NULL, 16),
-            idle_join);
-
-    FILE* fp = fopen(schedule_file_name, "r");
-    if (fp == NULL) {
+    struct mir_loop_precomp_t* precomp = mir_omp_loop_precomp_get((unsigned long)worker->current_task->func, idle_join);
+    if (precomp->exists == false)
         return;
-    }
     loop->precomp_schedule_exists = true;
-    int num_expect = 4;
-    int retval;
-    if (worker->id == 0) {
-        MIR_LOG_INFO("Using precomputed schedule file: %s.",
-                schedule_file_name);
+    if (worker->cpu_id <= MIR_WORKER_MAX_COUNT)
+        loop->precomp_schedule = precomp->chunks[worker->cpu_id];
+#endif
+} /*}}}*/
+
+struct mir_loop_des_t* mir_new_omp_loop_desc_init(long start, long end, long incr, long chunk_size, bool use_precomp_schedule)
+{/*{{{*/
+    struct mir_loop_des_t* loop = mir_new_omp_loop_desc();
+    mir_omp_loop_desc_init(loop, start, end, incr, chunk_size, use_precomp_schedule);
+
+    return loop;
+}/*}}}*/
+
+// The function mir_omp_loop_dynamic_next() takes the next chunk of
+// ... chunk_size iterations. A single fetch-and-add claims the chunk
+// ... unless overshooting end could overflow, then a CAS loop is used.
+// Returns false when all iterations are taken.
+
+bool mir_omp_loop_dynamic_next(struct mir_loop_des_t* loop, long* istart, long* iend)
+{ /*{{{*/
+    MIR_ASSERT(loop != NULL);
+
+    long end = loop->end;
+    long incr = loop->incr;
+    long chunk = (loop->chunk_size > 0 ? loop->chunk_size : 1) * incr;
+
+    if (loop->next_fetch_add == 1) {
+        long start = __sync_fetch_and_add(&loop->next, chunk);
+        if ((incr > 0 && start >= end) || (incr < 0 && start <= end))
+            return false;
+        long nend = start + chunk;
+        if ((incr > 0 && nend > end) || (incr < 0 && nend < end))
+            nend = end;
+        *istart = start;
+        *iend = nend;
+        return true;
     }
-    unsigned long chunk_start, chunk_end, cpu_id, work_cycles;
-    while (!feof(fp)) {
-        while (num_expect == (retval = fscanf(fp,
-                                  "%lu,%lu,%lu,%lu\n",
-                                  &chunk_start,
-                                  &chunk_end,
-                                  &cpu_id,
-                                  &work_cycles))) {
-            if (cpu_id == MIR_IMPOSSIBLE_CPU_ID) {
-                MIR_LOG_ERR("Precomputed schedule in file %s uses unsupported MIR_IMPOSSIBLE_CPU_ID.",
-                            schedule_file_name);
+
+    long start = loop->next;
+    while (1) {
+        if (start == end)
+            return false;
+        long left = end - start;
+        long step = chunk;
+        if ((incr > 0 && step > left) || (incr < 0 && step < left))
+            step = left;
+        long tmp = __sync_val_compare_and_swap(&loop->next, start, start + step);
+        if (tmp == start) {
+            *istart = start;
+            *iend = start + step;
+            return true;
+        }
+        start = tmp;
+    }
+} /*}}}*/
+
+// The function mir_omp_loop_guided_next() takes the next chunk of
+// ... remaining iterations divided by nthreads, but not less than
+// ... chunk_size, by a CAS loop on next.
+// Returns false when all iterations are taken.
+
+bool mir_omp_loop_guided_next(struct mir_loop_des_t* loop, unsigned nthreads, long* istart, long* iend)
+{ /*{{{*/
+    MIR_ASSERT(loop != NULL);
+    MIR_ASSERT(nthreads > 0);
+
+    long end = loop->end;
+    long incr = loop->incr;
+    unsigned long chunk_size = loop->chunk_size > 0 ? loop->chunk_size : 1;
+
+    long start = loop->next;
+    while (1) {
+        if (start == end)
+            return false;
+        unsigned long n = (end - start) / incr;
+        unsigned long q = (n + nthreads - 1) / nthreads;
+        if (q < chunk_size)
+            q = chunk_size;
+        long nend = q <= n ? start + q * incr : end;
+        long tmp = __sync_val_compare_and_swap(&loop->next, start, nend);
+        if (tmp == start) {
+            *istart = start;
+            *iend = nend;
+            return true;
+        }
+        start = tmp;
+    }
+} /*}}}*/
+
+// The function mir_omp_loop_ranges_init() deals the iterations to nthreads
+// ... contiguous ranges, sized by weights or evenly if weights is NULL.
+// Loops with more than 2^32 - 1 iterations get no ranges and are
+// ... dispatched dynamically.
+
+static inline unsigned long mir_omp_loop_num_iterations(const struct mir_loop_des_t* loop)
+{ /*{{{*/
+    unsigned long span, step;
+    if (loop->incr > 0) {
+        span = (unsigned long)loop->end - (unsigned long)loop->next;
+        step = loop->incr;
+    }
+    else {
+        span = (unsigned long)loop->next - (unsigned long)loop->end;
+        step = -(unsigned long)loop->incr;
+    }
+    return span / step + (span % step != 0);
+} /*}}}*/
+
+static void mir_omp_loop_ranges_init(struct mir_loop_des_t* loop, unsigned nthreads, const uint64_t* weights)
+{ /*{{{*/
+    MIR_ASSERT(loop != NULL);
+    MIR_ASSERT(nthreads > 0);
+
+    unsigned long n = mir_omp_loop_num_iterations(loop);
+    if (n > UINT32_MAX)
+        return;
+
+    double total = 0;
+    if (weights)
+        for (unsigned t = 0; t < nthreads; t++)
+            total += weights[t];
+
+    struct mir_loop_range_t* ranges = mir_malloc_int(nthreads * sizeof(struct mir_loop_range_t));
+    MIR_CHECK_MEM(ranges != NULL);
+    uint64_t lo = 0;
+    double sum = 0;
+    for (unsigned t = 0; t < nthreads; t++) {
+        uint64_t hi;
+        if (t == nthreads - 1)
+            hi = n;
+        else if (weights && total > 0) {
+            sum += weights[t];
+            hi = (uint64_t)(n * (sum / total));
+            if (hi < lo)
+                hi = lo;
+        }
+        else
+            hi = n * (t + 1) / nthreads;
+        ranges[t].bounds = (lo << 32) | hi;
+        ranges[t].executed = 0;
+        ranges[t].node = 0;
+        lo = hi;
+    }
+
+    loop->first = loop->next;
+    loop->num_iterations = n;
+    loop->ranges = ranges;
+    __sync_synchronize();
+    loop->num_ranges = nthreads;
+} /*}}}*/
+
+void mir_omp_loop_adaptive_init(struct mir_loop_des_t* loop, unsigned nthreads)
+{ /*{{{*/
+    mir_omp_loop_ranges_init(loop, nthreads, NULL);
+} /*}}}*/
+
+// The function mir_omp_loop_adaptive_next() takes the next chunk of the
+// ... range of thread. When the range is empty, the back half of the
+// ... fullest range is split off and taken over first.
+// Returns false when no range has iterations to spare.
+
+bool mir_omp_loop_adaptive_next(struct mir_loop_des_t* loop, unsigned thread, long* istart, long* iend)
+{ /*{{{*/
+    MIR_ASSERT(loop != NULL);
+
+    if (loop->num_ranges == 0)
+        return mir_omp_loop_dynamic_next(loop, istart, iend);
+    MIR_ASSERT(thread < loop->num_ranges);
+
+    uint64_t chunk = loop->chunk_size > 0 ? loop->chunk_size : 1;
+    struct mir_loop_range_t* own = &loop->ranges[thread];
+
+    while (1) {
+        // Take a chunk from the front of the own range
+        uint64_t bounds = own->bounds;
+        uint64_t lo = bounds >> 32;
+        uint64_t hi = bounds & UINT32_MAX;
+        if (lo < hi) {
+            uint64_t nlo = hi - lo > chunk ? lo + chunk : hi;
+            if (__sync_bool_compare_and_swap(&own->bounds, bounds, (nlo << 32) | hi)) {
+                own->executed += nlo - lo;
+                *istart = loop->first + (long)lo * loop->incr;
+                // The last iteration may be closer to end than incr
+                *iend = nlo == loop->num_iterations ? loop->end : loop->first + (long)nlo * loop->incr;
+                return true;
             }
-            else if (cpu_id > runtime->num_workers) {
-                MIR_LOG_ERR("Precomputed schedule in file %s has more workers than available.",
-                            schedule_file_name);
+            continue;
+        }
+
+        // Find the range with most iterations left
+        struct mir_loop_range_t* victim = NULL;
+        uint64_t victim_bounds = 0;
+        uint64_t most = 1;
+        for (unsigned t = 0; t < loop->num_ranges; t++) {
+            uint64_t b = loop->ranges[t].bounds;
+            uint64_t left = (b & UINT32_MAX) - (b >> 32);
+            if ((b >> 32) < (b & UINT32_MAX) && left > most) {
+                victim = &loop->ranges[t];
+                victim_bounds = b;
+                most = left;
             }
-            if (cpu_id != worker->cpu_id)
-                continue;
+        }
 
-            struct mir_loop_schedule_t* schedule = mir_malloc_int(sizeof(struct mir_loop_schedule_t));
-            MIR_CHECK_MEM(schedule != NULL);
-            schedule->chunk_start = chunk_start;
-            schedule->chunk_end = chunk_end;
+        // Single iterations are left to their owners
+        if (victim == NULL) {
+            // Record the share of this thread for the next instance
+            if (loop->affinity)
+                loop->affinity->executed[thread] = own->executed;
+            return false;
+        }
 
-            schedule->next = loop->precomp_schedule;
-            loop->precomp_schedule = schedule;
+        // Split off the back half and make it the own range
+        lo = victim_bounds >> 32;
+        hi = victim_bounds & UINT32_MAX;
+        uint64_t mid = hi - (hi - lo) / 2;
+        if (__sync_bool_compare_and_swap(&victim->bounds, victim_bounds, (lo << 32) | mid)) {
+            // Thieves leave empty ranges alone
+            own->bounds = (mid << 32) | hi;
+            __sync_synchronize();
         }
-        if (ferror(fp)) {
-            MIR_LOG_ERR("Error occured while reading precomputed schedule file: %s.",
-                        schedule_file_name);
+    }
+} /*}}}*/
+
+// Recorded shares of affinity loops
+static struct mir_loop_affinity_t* volatile g_loop_affinity[1 << MIR_LOOP_AFFINITY_TABLE_BITS];
+
+// The function mir_omp_loop_affinity_init() replays the partition of the last
+// ... instance of the loop. A loop is identified by the function of the
+// ... current task, its bounds and the number of threads. Each thread gets a
+// ... contiguous range sized by the iterations it executed last time, so that
+// ... it touches the same data again. Stealing corrects for imbalance and
+// ... the shares adapt for the next instance. First instances are dealt evenly.
+
+void mir_omp_loop_affinity_init(struct mir_loop_des_t* loop, unsigned nthreads)
+{ /*{{{*/
+    MIR_ASSERT(loop != NULL);
+    MIR_ASSERT(nthreads > 0 && nthreads <= MIR_WORKER_MAX_COUNT);
+
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT(worker != NULL);
+    void* func = worker->current_task ? (void*)worker->current_task->func : NULL;
+
+    uint64_t key = (uint64_t)(uintptr_t)func ^ (uint64_t)loop->next * 31 ^ (uint64_t)loop->end * 17 ^ (uint64_t)loop->incr * 7 ^ nthreads;
+    key ^= key >> 29;
+    key *= 0x9E3779B97F4A7C15ULL;
+    unsigned slot = key >> (64 - MIR_LOOP_AFFINITY_TABLE_BITS);
+
+    struct mir_loop_affinity_t* affinity;
+    for (affinity = g_loop_affinity[slot]; affinity; affinity = affinity->next)
+        if (affinity->func == func && affinity->start == loop->next && affinity->end == loop->end &&
+            affinity->incr == loop->incr && affinity->nthreads == nthreads)
+            break;
+
+    if (affinity == NULL) {
+        affinity = mir_malloc_int(sizeof(struct mir_loop_affinity_t));
+        MIR_CHECK_MEM(affinity != NULL);
+        affinity->func = func;
+        affinity->start = loop->next;
+        affinity->end = loop->end;
+        affinity->incr = loop->incr;
+        affinity->nthreads = nthreads;
+        for (unsigned t = 0; t < nthreads; t++)
+            affinity->executed[t] = 0;
+        do
+            affinity->next = g_loop_affinity[slot];
+        while (!__sync_bool_compare_and_swap(&g_loop_affinity[slot], affinity->next, affinity));
+        mir_omp_loop_ranges_init(loop, nthreads, NULL);
+    }
+    else {
+        // Threads that executed little keep a minimum share
+        uint64_t weights[MIR_WORKER_MAX_COUNT];
+        uint64_t total = 0;
+        for (unsigned t = 0; t < nthreads; t++)
+            total += affinity->executed[t];
+        uint64_t floor = total / (nthreads * MIR_LOOP_AFFINITY_MIN_SHARE);
+        for (unsigned t = 0; t < nthreads; t++)
+            weights[t] = affinity->executed[t] > floor ? affinity->executed[t] : floor;
+        mir_omp_loop_ranges_init(loop, nthreads, total > 0 ? weights : NULL);
+    }
+
+    loop->affinity = affinity;
+} /*}}}*/
+
+void mir_omp_loop_affinity_destroy()
+{ /*{{{*/
+    for (int slot = 0; slot < (1 << MIR_LOOP_AFFINITY_TABLE_BITS); slot++) {
+        while (g_loop_affinity[slot]) {
+            struct mir_loop_affinity_t* affinity = g_loop_affinity[slot];
+            g_loop_affinity[slot] = affinity->next;
+            mir_free_int(affinity, sizeof(struct mir_loop_affinity_t));
         }
-        else if (retval != EOF) {
-            // Skip over.
-            retval = fscanf(fp, "%*[^\n]");
+    }
+} /*}}}*/
+
+// Footprint registered outside of tasks
+static void* volatile g_loop_base = NULL;
+static volatile size_t g_loop_stride = 0;
+
+// The function mir_loop_set_footprint() registers the data of numa loops
+// ... started by the current task and its children. Iteration number i
+// ... accesses the stride bytes at base + i * stride. A NULL base unregisters.
+
+void mir_loop_set_footprint(void* base, size_t stride)
+{ /*{{{*/
+    MIR_ASSERT(base == NULL || stride > 0);
+
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    if (worker && worker->current_task) {
+        worker->current_task->loop_base = base;
+        worker->current_task->loop_stride = stride;
+    }
+    else {
+        g_loop_base = base;
+        g_loop_stride = stride;
+    }
+} /*}}}*/
+
+// The function mir_omp_loop_numa_init() deals the iterations to ranges on
+// ... the nodes holding their data. The iterations are cut into at most
+// ... MIR_LOOP_NUMA_SEGMENTS segments. The node of a segment is the node
+// ... holding the page of its first iteration, and neighbouring segments on
+// ... the same node are merged. Without a registered footprint the segments
+// ... are dealt evenly to nodes. Chunks default to a static share per thread.
+
+void mir_omp_loop_numa_init(struct mir_loop_des_t* loop, unsigned nthreads)
+{ /*{{{*/
+    MIR_ASSERT(loop != NULL);
+    MIR_ASSERT(nthreads > 0);
+
+    unsigned long n = mir_omp_loop_num_iterations(loop);
+    if (n == 0 || n > UINT32_MAX)
+        return;
+
+    uint16_t num_nodes = runtime->arch->num_nodes;
+    unsigned num_segments = n < MIR_LOOP_NUMA_SEGMENTS ? n : MIR_LOOP_NUMA_SEGMENTS;
+    uint16_t nodes[MIR_LOOP_NUMA_SEGMENTS];
+    for (unsigned s = 0; s < num_segments; s++)
+        nodes[s] = s * num_nodes / num_segments;
+
+#ifdef MIR_MEM_POL_ENABLE
+    // The innermost task with a footprint decides
+    char* base = g_loop_base;
+    size_t stride = g_loop_stride;
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    for (struct mir_task_t* task = worker ? worker->current_task : NULL; task; task = task->parent) {
+        if (task->loop_base) {
+            base = task->loop_base;
+            stride = task->loop_stride;
+            break;
         }
     }
-    fclose(fp);
+
+    if (base && num_nodes > 1)
+        for (unsigned s = 0; s < num_segments; s++)
+            nodes[s] = mir_mem_get_page_node(base + n * s / num_segments * stride);
 #endif
+
+    unsigned num_ranges = 1;
+    for (unsigned s = 1; s < num_segments; s++)
+        if (nodes[s] != nodes[s - 1])
+            num_ranges++;
+
+    struct mir_loop_range_t* ranges = mir_malloc_int(num_ranges * sizeof(struct mir_loop_range_t));
+    MIR_CHECK_MEM(ranges != NULL);
+    unsigned r = 0;
+    uint64_t lo = 0;
+    for (unsigned s = 1; s <= num_segments; s++) {
+        if (s < num_segments && nodes[s] == nodes[s - 1])
+            continue;
+        uint64_t hi = n * s / num_segments;
+        ranges[r].bounds = (lo << 32) | hi;
+        ranges[r].executed = 0;
+        ranges[r].node = nodes[s - 1];
+        r++;
+        lo = hi;
+    }
+    MIR_ASSERT(r == num_ranges);
+
+    if (loop->chunk_size <= 0)
+        loop->chunk_size = n / nthreads > 0 ? n / nthreads : 1;
+    loop->first = loop->next;
+    loop->num_iterations = n;
+    loop->ranges = ranges;
+    __sync_synchronize();
+    loop->num_ranges = num_ranges;
 } /*}}}*/
 
-struct mir_loop_des_t* mir_new_omp_loop_desc_init(long start, long end, long incr, long chunk_size, bool use_precomp_schedule)
-{/*{{{*/
-    struct mir_loop_des_t* loop = mir_new_omp_loop_desc();
-    mir_omp_loop_desc_init(loop, start, end, incr, chunk_size, use_precomp_schedule);
+// The function mir_omp_loop_numa_next() takes the next chunk of a range on
+// ... the node of the calling worker. When those are empty, the chunk comes
+// ... from the fullest range left. Returns false when all ranges are empty.
 
-    return loop;
-}/*}}}*/
+bool mir_omp_loop_numa_next(struct mir_loop_des_t* loop, long* istart, long* iend)
+{ /*{{{*/
+    MIR_ASSERT(loop != NULL);
+
+    if (loop->num_ranges == 0)
+        return mir_omp_loop_dynamic_next(loop, istart, iend);
+
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT(worker != NULL);
+    uint16_t node = runtime->arch->node_of(worker->cpu_id);
+    uint64_t chunk = loop->chunk_size > 0 ? loop->chunk_size : 1;
+
+    while (1) {
+        struct mir_loop_range_t* range = NULL;
+        uint64_t bounds = 0;
+        uint64_t most = 0;
+        for (unsigned r = 0; r < loop->num_ranges; r++) {
+            uint64_t b = loop->ranges[r].bounds;
+            uint64_t left = (b & UINT32_MAX) - (b >> 32);
+            if (left == 0)
+                continue;
+            if (loop->ranges[r].node == node) {
+                range = &loop->ranges[r];
+                bounds = b;
+                break;
+            }
+            if (left > most) {
+                range = &loop->ranges[r];
+                bounds = b;
+                most = left;
+            }
+        }
+
+        if (range == NULL)
+            return false;
+
+        // Ranges only shrink from the front
+        uint64_t lo = bounds >> 32;
+        uint64_t hi = bounds & UINT32_MAX;
+        uint64_t nlo = hi - lo > chunk ? lo + chunk : hi;
+        if (__sync_bool_compare_and_swap(&range->bounds, bounds, (nlo << 32) | hi)) {
+            *istart = loop->first + (long)lo * loop->incr;
+            // The last iteration may be closer to end than incr
+            *iend = nlo == loop->num_iterations ? loop->end : loop->first + (long)nlo * loop->incr;
+            return true;
+        }
+    }
+} /*}}}*/
+
+// The function mir_omp_loop_schedule_parse() reads a schedule given as
+// ... kind[,chunk_size], as in OMP_SCHEDULE. Returns 0 on success.
+
+int mir_omp_loop_schedule_parse(const char* str, enum omp_for_schedule_t* schedule, long* chunk_size)
+{ /*{{{*/
+    MIR_ASSERT(str != NULL);
+
+    static const struct {
+        const char* name;
+        enum omp_for_schedule_t kind;
+    } kinds[] = {
+        { "static", OFS_STATIC },
+        { "dynamic", OFS_DYNAMIC },
+        { "guided", OFS_GUIDED },
+        { "auto", OFS_AUTO },
+        { "adaptive", OFS_ADAPTIVE },
+        { "affinity", OFS_AFFINITY },
+        { "numa", OFS_NUMA },
+    };
+
+    for (int i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+        size_t len = strlen(kinds[i].name);
+        if (strncasecmp(str, kinds[i].name, len) != 0)
+            continue;
+        if (str[len] == '\0') {
+            *schedule = kinds[i].kind;
+            *chunk_size = 0;
+            return 0;
+        }
+        if (str[len] != ',')
+            return -1;
+        char* endp;
+        long chunk = strtol(&str[len + 1], &endp, 10);
+        if (*endp != '\0' || chunk <= 0)
+            return -1;
+        *schedule = kinds[i].kind;
+        *chunk_size = chunk;
+        return 0;
+    }
+
+    return -1;
+} /*}}}*/
+
+// Shared by the members of a parallel loop
+struct mir_loop_parallel_t { /*{{{*/
+    mir_loop_func_t func;
+    void* data;
+    long start;
+    long end;
+    enum omp_for_schedule_t schedule;
+    long chunk_size;
+    unsigned nthreads;
+    struct mir_loop_des_t loop;
+}; /*}}}*/
+
+// The function mir_loop_parallel_static() executes the iterations of
+// ... thread. Without a chunk size each thread gets one contiguous share,
+// ... otherwise chunks are dealt round-robin.
+
+static void mir_loop_parallel_static(const struct mir_loop_parallel_t* par, unsigned thread)
+{ /*{{{*/
+    unsigned long n = par->end - par->start;
+
+    if (par->chunk_size <= 0) {
+        unsigned long q = n / par->nthreads;
+        unsigned long r = n % par->nthreads;
+        unsigned long lo = q * thread + (thread < r ? thread : r);
+        unsigned long hi = lo + q + (thread < r);
+        if (lo < hi)
+            par->func(par->start + lo, par->start + hi, par->data);
+        return;
+    }
+
+    unsigned long chunk = par->chunk_size;
+    for (unsigned long lo = chunk * thread; lo < n; lo += chunk * par->nthreads) {
+        unsigned long hi = n - lo > chunk ? lo + chunk : n;
+        par->func(par->start + lo, par->start + hi, par->data);
+        if (n - lo <= chunk * par->nthreads)
+            break;
+    }
+} /*}}}*/
+
+static void* mir_loop_parallel_block(void* arg)
+{ /*{{{*/
+    struct mir_loop_parallel_t* par = *(struct mir_loop_parallel_t**)arg;
+    struct mir_worker_t* worker = mir_worker_get_context();
+    struct mir_task_t* block = worker->current_task;
+    MIR_ASSERT(block != NULL && block->team != NULL);
+    unsigned thread = block - block->team->members;
+    long istart, iend;
+
+    switch (par->schedule) {
+        case OFS_DYNAMIC:
+            while (mir_omp_loop_dynamic_next(&par->loop, &istart, &iend))
+                par->func(istart, iend, par->data);
+            break;
+        case OFS_GUIDED:
+            while (mir_omp_loop_guided_next(&par->loop, par->nthreads, &istart, &iend))
+                par->func(istart, iend, par->data);
+            break;
+        case OFS_ADAPTIVE:
+        case OFS_AFFINITY:
+            while (mir_omp_loop_adaptive_next(&par->loop, thread, &istart, &iend))
+                par->func(istart, iend, par->data);
+            break;
+        case OFS_NUMA:
+            while (mir_omp_loop_numa_next(&par->loop, &istart, &iend))
+                par->func(istart, iend, par->data);
+            break;
+        default:
+            mir_loop_parallel_static(par, thread);
+            break;
+    }
+
+    return NULL;
+} /*}}}*/
+
+// The function mir_loop_parallel() executes iterations [start, end) of func
+// ... on a team of all workers. The schedule is given as kind[,chunk_size],
+// ... as with --loop-schedule, and NULL selects static. Teams come from the
+// ... pool, so a loop costs a region start and a join.
+// Tasks created before by the caller are joined as well.
+
+void mir_loop_parallel(mir_loop_func_t func, void* data, long start, long end, const char* schedule)
+{ /*{{{*/
+    MIR_ASSERT(func != NULL);
+
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    MIR_ASSERT_STR(worker != NULL, "Parallel loops can be started only by workers.");
+
+    struct mir_loop_parallel_t par;
+    par.func = func;
+    par.data = data;
+    par.start = start;
+    par.end = end > start ? end : start;
+    par.schedule = OFS_STATIC;
+    par.chunk_size = 0;
+    if (schedule && 0 != mir_omp_loop_schedule_parse(schedule, &par.schedule, &par.chunk_size))
+        MIR_LOG_ERR("Loop schedule %s is not valid.", schedule);
+    par.nthreads = runtime->num_workers;
+    mir_omp_loop_desc_init(&par.loop, par.start, par.end, 1, par.chunk_size, false);
+    if (par.schedule == OFS_ADAPTIVE)
+        mir_omp_loop_adaptive_init(&par.loop, par.nthreads);
+    else if (par.schedule == OFS_AFFINITY)
+        mir_omp_loop_affinity_init(&par.loop, par.nthreads);
+    else if (par.schedule == OFS_NUMA)
+        mir_omp_loop_numa_init(&par.loop, par.nthreads);
+
+    struct mir_omp_team_t* pteam = worker->current_task ? worker->current_task->team : NULL;
+    struct mir_omp_team_t* team = mir_new_omp_team(pteam, par.nthreads);
+    struct mir_loop_parallel_t* ppar = &par;
+    mir_omp_team_start(team, mir_loop_parallel_block, &ppar, sizeof(ppar), "parallel_loop");
+    mir_task_wait();
+    mir_release_omp_team(team);
+
+    if (par.loop.ranges)
+        mir_free_int(par.loop.ranges, par.loop.num_ranges * sizeof(struct mir_loop_range_t));
+} /*}}}*/
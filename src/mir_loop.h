@@ -2,14 +2,19 @@
 #define MIR_LOOP_H 1
 
 #include <stdbool.h>
+#include <stdint.h>
 
+#include "mir_defines.h"
 #include "mir_lock.h"
+#include "mir_omp_int.h"
 
 BEGIN_C_DECLS
 
 /*PUB_INT_DECL_BEGIN*/
 
 struct mir_loop_schedule_t;
+struct mir_loop_range_t;
+struct mir_loop_affinity_t;
 
 struct mir_loop_schedule_t {
     unsigned long chunk_start;
@@ -23,17 +28,64 @@ struct mir_loop_des_t {
     long end;
     long incr;
     long chunk_size;
-    long next;
+    // Advanced atomically by dynamic and guided dispatch
+    volatile long next;
+    // Set when next can be advanced past end without overflow
+    int next_fetch_add;
     long static_trip;
     struct mir_lock_t lock;
+    // Chunks of this worker, shared through the schedule cache
     struct mir_loop_schedule_t* precomp_schedule;
     bool precomp_schedule_exists;
+    // For the adaptive schedule
+    long first;
+    uint32_t num_iterations;
+    unsigned num_ranges;
+    struct mir_loop_range_t* ranges;
+    struct mir_loop_affinity_t* affinity;
 };
 /*PUB_INT_DECL_END*/
 
+// Iteration numbers owned by a thread of an adaptive loop
+// Bounds are packed as first << 32 | end. The owner takes chunks from the
+// ... front, thieves split off the back half.
+struct mir_loop_range_t { /*{{{*/
+    volatile uint64_t bounds;
+    uint64_t executed; // Iterations the owner executed
+    uint16_t node; // Node holding the data of a numa loop range
+    char pad[MIR_LOOP_RANGE_SIZE - 2 * sizeof(uint64_t) - sizeof(uint16_t)];
+}; /*}}}*/
+
+// Iterations each thread executed in the last instance of an affinity loop
+struct mir_loop_affinity_t { /*{{{*/
+    void* func;
+    long start;
+    long end;
+    long incr;
+    unsigned nthreads;
+    volatile uint64_t executed[MIR_WORKER_MAX_COUNT];
+    struct mir_loop_affinity_t* next;
+}; /*}}}*/
+
 struct mir_loop_des_t* mir_new_omp_loop_desc();
 void mir_omp_loop_desc_init(struct mir_loop_des_t* loop, long start, long end, long incr, long chunk_size, bool use_precomp_schedule);
 struct mir_loop_des_t* mir_new_omp_loop_desc_init(long start, long end, long incr, long chunk_size, bool use_precomp_schedule);
+bool mir_omp_loop_dynamic_next(struct mir_loop_des_t* loop, long* istart, long* iend);
+bool mir_omp_loop_guided_next(struct mir_loop_des_t* loop, unsigned nthreads, long* istart, long* iend);
+void mir_omp_loop_adaptive_init(struct mir_loop_des_t* loop, unsigned nthreads);
+bool mir_omp_loop_adaptive_next(struct mir_loop_des_t* loop, unsigned thread, long* istart, long* iend);
+void mir_omp_loop_affinity_init(struct mir_loop_des_t* loop, unsigned nthreads);
+void mir_omp_loop_affinity_destroy();
+void mir_omp_loop_precomp_destroy();
+void mir_omp_loop_numa_init(struct mir_loop_des_t* loop, unsigned nthreads);
+bool mir_omp_loop_numa_next(struct mir_loop_des_t* loop, long* istart, long* iend);
+/*PUB_INT*/ void mir_loop_set_footprint(void* base, size_t stride);
+int mir_omp_loop_schedule_parse(const char* str, enum omp_for_schedule_t* schedule, long* chunk_size);
+
+// The parallel loop body executes iterations [start, end)
+/*PUB_INT*/ typedef void (*mir_loop_func_t)(long, long, void*);
+
+/*PUB_INT*/ void mir_loop_parallel(mir_loop_func_t func, void* data, long start, long end, const char* schedule);
 
 END_C_DECLS
 #endif
@@ -209,6 +209,21 @@ void mir_mem_get_mem_node_dist(struct mir_mem_node_dist_t* dist, void* addr, siz
 #endif
 } /*}}}*/
 
+// The function mir_mem_get_page_node() returns the node holding the page of addr.
+// Unlike mir_mem_get_mem_node_dist(), it does not look for an allocation
+// ... header before addr, so it is safe on any mapped address.
+
+uint16_t mir_mem_get_page_node(void* addr)
+{ /*{{{*/
+    MIR_ASSERT(addr != NULL);
+#ifndef __tile__
+    return get_node_from_system(addr);
+#else
+    // FIXME: What happens on TILEPRO64?
+    return 0;
+#endif
+} /*}}}*/
+
 struct mir_mem_pol_t { /*{{{*/
     struct mir_lock_t lock;
     uint16_t node;
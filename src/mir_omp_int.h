@@ -15,7 +15,10 @@ enum omp_for_schedule_t {
     OFS_STATIC,
     OFS_DYNAMIC,
     OFS_GUIDED,
-    OFS_AUTO
+    OFS_AUTO,
+    OFS_ADAPTIVE,
+    OFS_AFFINITY,
+    OFS_NUMA
 };
 
 /* Refactored from GCC git repository git://gcc.gnu.org/git/gcc.git HEAD ae76874abdf11bb77597f7285cb115bd78e82fda */
@@ -30,8 +33,11 @@ void GOMP_barrier(void);
 
 /* critical.c */
 
+// Defined by the runtime in mir_omp_lock.c. The shim must not define them.
 void GOMP_critical_start(void);
 void GOMP_critical_end(void);
+void GOMP_critical_name_start(void** pptr);
+void GOMP_critical_name_end(void** pptr);
 void GOMP_atomic_start(void);
 void GOMP_atomic_end(void);
 
@@ -64,8 +70,38 @@ void GOMP_parallel_end(void);
 
 /* task.c */
 
+#define GOMP_TASK_FLAG_UNTIED (1 << 0)
+#define GOMP_TASK_FLAG_FINAL (1 << 1)
+#define GOMP_TASK_FLAG_MERGEABLE (1 << 2)
+#define GOMP_TASK_FLAG_DEPEND (1 << 3)
+#define GOMP_TASK_FLAG_PRIORITY (1 << 4)
+#define GOMP_TASK_FLAG_UP (1 << 8)
+#define GOMP_TASK_FLAG_GRAINSIZE (1 << 9)
+#define GOMP_TASK_FLAG_IF (1 << 10)
+#define GOMP_TASK_FLAG_NOGROUP (1 << 11)
+
+// GCC passes a trailing priority argument when GOMP_TASK_FLAG_PRIORITY is set.
+// The prototype leaves it out so the shim keeps its definition. A shim
+// ... reading it passes it on through mir_task_create_on_worker_attr()
+// ... or mir_task_create_on_worker_depend_attr().
 void GOMP_task(void (*fn)(void*), void* data, void (*cpyfn)(void*, void*), long arg_size, long arg_align, bool if_clause, unsigned flags, void** depend);
 void GOMP_taskwait(void);
+// Defined by the runtime in mir_taskgroup.c. The shim must not define them.
+void GOMP_taskgroup_start(void);
+void GOMP_taskgroup_end(void);
+// Defined by the runtime in mir_taskloop.c. The shim must not define it.
+void GOMP_taskloop(void (*fn)(void*), void* data, void (*cpyfn)(void*, void*), long arg_size, long arg_align, unsigned flags, unsigned long num_tasks, int priority, long start, long end, long step);
+
+/* cancel */
+
+#define GOMP_CANCEL_PARALLEL 1
+#define GOMP_CANCEL_LOOP 2
+#define GOMP_CANCEL_SECTIONS 4
+#define GOMP_CANCEL_TASKGROUP 8
+
+// Defined by the runtime in mir_taskgroup.c. The shim must not define them.
+bool GOMP_cancel(int which, bool do_cancel);
+bool GOMP_cancellation_point(int which);
 
 /* single.c */
 
@@ -73,14 +109,17 @@ bool GOMP_single_start(void);
 
 /* omp.h */
 
+// Programs allocate locks as sized in the omp.h of libgomp, 4 bytes for
+// ... omp_lock_t and 8 + sizeof(void*) bytes for omp_nest_lock_t. The
+// ... runtime uses no more than that, see mir_omp_lock.h.
 typedef struct
 {
-  unsigned char _x[42]; // 42 is a bogus number. The data structure is not supported.
+  unsigned char _x[42]; // 42 is a bogus number. Only the libgomp size is used.
 } omp_lock_t;
 
 typedef struct
 {
-  unsigned char _x[42]; // 42 is a bogus number. The data structure is not supported.
+  unsigned char _x[42]; // 42 is a bogus number. Only the libgomp size is used.
 } omp_nest_lock_t;
 
 typedef enum omp_sched_t
@@ -114,6 +153,7 @@ int omp_get_dynamic (void);
 void omp_set_nested (int);
 int omp_get_nested (void);
 
+// Defined by the runtime in mir_omp_lock.c. The shim must not define them.
 void omp_init_lock (omp_lock_t *);
 void omp_destroy_lock (omp_lock_t *);
 void omp_set_lock (omp_lock_t *);
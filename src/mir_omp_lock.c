@@ -0,0 +1,302 @@
+#include "mir_omp_lock.h"
+#include "mir_task.h"
+#include "mir_worker.h"
+#include "mir_utils.h"
+#include "mir_defines.h"
+
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// The locks live in objects sized and aligned by libgomp
+typedef char mir_omp_lock_fits[sizeof(struct mir_omp_lock_t) <= MIR_OMP_LOCK_GOMP_SIZE && __alignof__(struct mir_omp_lock_t) <= MIR_OMP_LOCK_GOMP_SIZE && MIR_OMP_LOCK_GOMP_SIZE <= sizeof(omp_lock_t) ? 1 : -1];
+typedef char mir_omp_nest_lock_fits[sizeof(struct mir_omp_nest_lock_t) <= MIR_OMP_NEST_LOCK_GOMP_SIZE && __alignof__(struct mir_omp_nest_lock_t) <= MIR_OMP_NEST_LOCK_GOMP_ALIGN && MIR_OMP_NEST_LOCK_GOMP_SIZE <= sizeof(omp_nest_lock_t) ? 1 : -1];
+// Named critical sections keep their lock in the slot the compiler emits per name
+typedef char mir_omp_critical_lock_fits[sizeof(struct mir_omp_lock_t) <= sizeof(void*) ? 1 : -1];
+
+// Lock of unnamed critical sections
+static struct mir_omp_lock_t g_omp_critical_lock = { 0 };
+
+// Locks of atomic updates, selected by address
+static struct mir_omp_atomic_lock_t g_omp_atomic_locks[1 << MIR_OMP_ATOMIC_LOCK_BITS] __attribute__((aligned(MIR_OMP_ATOMIC_LOCK_SIZE)));
+
+static inline void mir_omp_lock_park(volatile int* state)
+{ /*{{{*/
+    syscall(SYS_futex, state, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+} /*}}}*/
+
+static inline void mir_omp_lock_wake(volatile int* state)
+{ /*{{{*/
+    syscall(SYS_futex, state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+} /*}}}*/
+
+void mir_omp_lock_init(omp_lock_t* lock)
+{ /*{{{*/
+    MIR_ASSERT(lock != NULL);
+    ((struct mir_omp_lock_t*)lock)->state = 0;
+} /*}}}*/
+
+void mir_omp_lock_destroy(omp_lock_t* lock)
+{ /*{{{*/
+    MIR_ASSERT(lock != NULL);
+    MIR_ASSERT_STR(((struct mir_omp_lock_t*)lock)->state == 0, "Destroying a held OpenMP lock.");
+} /*}}}*/
+
+// The function mir_omp_lock_set() spins while the holder is likely to
+// ... release soon, then parks until woken by mir_omp_lock_unset().
+// Each worker adapts its own spin count: raised when spinning acquires
+// ... the lock, lowered when it parks anyway. Other threads do not adapt.
+
+void mir_omp_lock_set(omp_lock_t* lock)
+{ /*{{{*/
+    MIR_ASSERT(lock != NULL);
+    volatile int* state = &((struct mir_omp_lock_t*)lock)->state;
+
+    if (__sync_bool_compare_and_swap(state, 0, 1))
+        return;
+
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    int spin_count = worker ? worker->omp_lock_spin_count : MIR_OMP_LOCK_SPIN_COUNT;
+    for (int i = 0; i < spin_count; i++) {
+        if (*state == 0 && __sync_bool_compare_and_swap(state, 0, 1)) {
+            if (worker && spin_count < MIR_OMP_LOCK_SPIN_MAX)
+                worker->omp_lock_spin_count = spin_count + spin_count / 8 + 1;
+            return;
+        }
+        __sync_synchronize();
+    }
+
+    if (worker && spin_count > MIR_OMP_LOCK_SPIN_MIN)
+        worker->omp_lock_spin_count = spin_count - spin_count / 8;
+
+    // Mark the lock contended so that the holder wakes a waiter
+    while (__sync_lock_test_and_set(state, 2) != 0)
+        mir_omp_lock_park(state);
+} /*}}}*/
+
+void mir_omp_lock_unset(omp_lock_t* lock)
+{ /*{{{*/
+    MIR_ASSERT(lock != NULL);
+    volatile int* state = &((struct mir_omp_lock_t*)lock)->state;
+    MIR_ASSERT_STR(*state != 0, "Unsetting a free OpenMP lock.");
+
+    if (__sync_fetch_and_sub(state, 1) != 1) {
+        *state = 0;
+        __sync_synchronize();
+        mir_omp_lock_wake(state);
+    }
+} /*}}}*/
+
+int mir_omp_lock_test(omp_lock_t* lock)
+{ /*{{{*/
+    MIR_ASSERT(lock != NULL);
+    volatile int* state = &((struct mir_omp_lock_t*)lock)->state;
+
+    return *state == 0 && __sync_bool_compare_and_swap(state, 0, 1);
+} /*}}}*/
+
+// The function mir_omp_nest_lock_owner() identifies the caller.
+// OpenMP nest locks are owned by tasks, which may move between workers.
+
+static inline void* mir_omp_nest_lock_owner()
+{ /*{{{*/
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    if (worker == NULL)
+        return (void*)pthread_self();
+    if (worker->current_task)
+        return worker->current_task;
+    return worker;
+} /*}}}*/
+
+void mir_omp_nest_lock_init(omp_nest_lock_t* lock)
+{ /*{{{*/
+    MIR_ASSERT(lock != NULL);
+    struct mir_omp_nest_lock_t* nest_lock = (struct mir_omp_nest_lock_t*)lock;
+    mir_omp_lock_init((omp_lock_t*)&nest_lock->lock);
+    nest_lock->count = 0;
+    nest_lock->owner = NULL;
+} /*}}}*/
+
+void mir_omp_nest_lock_destroy(omp_nest_lock_t* lock)
+{ /*{{{*/
+    MIR_ASSERT(lock != NULL);
+    struct mir_omp_nest_lock_t* nest_lock = (struct mir_omp_nest_lock_t*)lock;
+    MIR_ASSERT_STR(nest_lock->count == 0, "Destroying a held OpenMP nest lock.");
+    mir_omp_lock_destroy((omp_lock_t*)&nest_lock->lock);
+} /*}}}*/
+
+void mir_omp_nest_lock_set(omp_nest_lock_t* lock)
+{ /*{{{*/
+    MIR_ASSERT(lock != NULL);
+    struct mir_omp_nest_lock_t* nest_lock = (struct mir_omp_nest_lock_t*)lock;
+    void* owner = mir_omp_nest_lock_owner();
+
+    // Only the owner itself can have stored its identity
+    if (nest_lock->owner != owner) {
+        mir_omp_lock_set((omp_lock_t*)&nest_lock->lock);
+        nest_lock->owner = owner;
+    }
+    nest_lock->count++;
+} /*}}}*/
+
+void mir_omp_nest_lock_unset(omp_nest_lock_t* lock)
+{ /*{{{*/
+    MIR_ASSERT(lock != NULL);
+    struct mir_omp_nest_lock_t* nest_lock = (struct mir_omp_nest_lock_t*)lock;
+    MIR_ASSERT_STR(nest_lock->owner == mir_omp_nest_lock_owner(), "Unsetting an OpenMP nest lock held by another task.");
+
+    if (--nest_lock->count == 0) {
+        nest_lock->owner = NULL;
+        mir_omp_lock_unset((omp_lock_t*)&nest_lock->lock);
+    }
+} /*}}}*/
+
+// The function mir_omp_nest_lock_test() returns the new nesting depth,
+// ... or 0 if the lock is held by another task.
+
+int mir_omp_nest_lock_test(omp_nest_lock_t* lock)
+{ /*{{{*/
+    MIR_ASSERT(lock != NULL);
+    struct mir_omp_nest_lock_t* nest_lock = (struct mir_omp_nest_lock_t*)lock;
+    void* owner = mir_omp_nest_lock_owner();
+
+    if (nest_lock->owner != owner) {
+        if (!mir_omp_lock_test((omp_lock_t*)&nest_lock->lock))
+            return 0;
+        nest_lock->owner = owner;
+    }
+
+    return ++nest_lock->count;
+} /*}}}*/
+
+void mir_omp_critical_start()
+{ /*{{{*/
+    mir_omp_lock_set((omp_lock_t*)&g_omp_critical_lock);
+} /*}}}*/
+
+void mir_omp_critical_end()
+{ /*{{{*/
+    mir_omp_lock_unset((omp_lock_t*)&g_omp_critical_lock);
+} /*}}}*/
+
+// The function mir_omp_critical_name_start() enters the critical section
+// ... of a name. The compiler emits one zeroed pointer-sized slot per name,
+// ... shared by all translation units, and the lock lives in that slot.
+// Sections of different names do not contend.
+
+void mir_omp_critical_name_start(void** pptr)
+{ /*{{{*/
+    MIR_ASSERT(pptr != NULL);
+    mir_omp_lock_set((omp_lock_t*)pptr);
+} /*}}}*/
+
+void mir_omp_critical_name_end(void** pptr)
+{ /*{{{*/
+    MIR_ASSERT(pptr != NULL);
+    mir_omp_lock_unset((omp_lock_t*)pptr);
+} /*}}}*/
+
+static inline struct mir_omp_lock_t* mir_omp_atomic_lock_of(void* addr)
+{ /*{{{*/
+    uint64_t key = ((uint64_t)(uintptr_t)addr >> 3) * 0x9E3779B97F4A7C15ULL;
+    return &g_omp_atomic_locks[key >> (64 - MIR_OMP_ATOMIC_LOCK_BITS)].lock;
+} /*}}}*/
+
+// The function mir_omp_atomic_start() begins an atomic update of addr that
+// ... has no hardware support. Updates of different addresses mostly take
+// ... different locks. GOMP_atomic_start() carries no address, so its
+// ... updates pass NULL and share one lock. An address must be updated
+// ... either always with or always without giving it.
+
+void mir_omp_atomic_start(void* addr)
+{ /*{{{*/
+    mir_omp_lock_set((omp_lock_t*)mir_omp_atomic_lock_of(addr));
+} /*}}}*/
+
+void mir_omp_atomic_end(void* addr)
+{ /*{{{*/
+    mir_omp_lock_unset((omp_lock_t*)mir_omp_atomic_lock_of(addr));
+} /*}}}*/
+
+#ifdef MIR_GPL
+void omp_init_lock(omp_lock_t* lock)
+{ /*{{{*/
+    mir_omp_lock_init(lock);
+} /*}}}*/
+
+void omp_destroy_lock(omp_lock_t* lock)
+{ /*{{{*/
+    mir_omp_lock_destroy(lock);
+} /*}}}*/
+
+void omp_set_lock(omp_lock_t* lock)
+{ /*{{{*/
+    mir_omp_lock_set(lock);
+} /*}}}*/
+
+void omp_unset_lock(omp_lock_t* lock)
+{ /*{{{*/
+    mir_omp_lock_unset(lock);
+} /*}}}*/
+
+int omp_test_lock(omp_lock_t* lock)
+{ /*{{{*/
+    return mir_omp_lock_test(lock);
+} /*}}}*/
+
+void omp_init_nest_lock(omp_nest_lock_t* lock)
+{ /*{{{*/
+    mir_omp_nest_lock_init(lock);
+} /*}}}*/
+
+void omp_destroy_nest_lock(omp_nest_lock_t* lock)
+{ /*{{{*/
+    mir_omp_nest_lock_destroy(lock);
+} /*}}}*/
+
+void omp_set_nest_lock(omp_nest_lock_t* lock)
+{ /*{{{*/
+    mir_omp_nest_lock_set(lock);
+} /*}}}*/
+
+void omp_unset_nest_lock(omp_nest_lock_t* lock)
+{ /*{{{*/
+    mir_omp_nest_lock_unset(lock);
+} /*}}}*/
+
+int omp_test_nest_lock(omp_nest_lock_t* lock)
+{ /*{{{*/
+    return mir_omp_nest_lock_test(lock);
+} /*}}}*/
+
+void GOMP_critical_start(void)
+{ /*{{{*/
+    mir_omp_critical_start();
+} /*}}}*/
+
+void GOMP_critical_end(void)
+{ /*{{{*/
+    mir_omp_critical_end();
+} /*}}}*/
+
+void GOMP_critical_name_start(void** pptr)
+{ /*{{{*/
+    mir_omp_critical_name_start(pptr);
+} /*}}}*/
+
+void GOMP_critical_name_end(void** pptr)
+{ /*{{{*/
+    mir_omp_critical_name_end(pptr);
+} /*}}}*/
+
+void GOMP_atomic_start(void)
+{ /*{{{*/
+    mir_omp_atomic_start(NULL);
+} /*}}}*/
+
+void GOMP_atomic_end(void)
+{ /*{{{*/
+    mir_omp_atomic_end(NULL);
+} /*}}}*/
+#endif
@@ -0,0 +1,58 @@
+#ifndef MIR_OMP_LOCK_H
+#define MIR_OMP_LOCK_H 1
+
+#include "mir_types.h"
+#include "mir_defines.h"
+#include "mir_omp_int.h"
+
+BEGIN_C_DECLS
+
+// Sizes and alignments of the lock objects programs allocate from libgomp's omp.h
+#define MIR_OMP_LOCK_GOMP_SIZE 4
+#define MIR_OMP_NEST_LOCK_GOMP_SIZE (8 + sizeof(void*))
+#define MIR_OMP_NEST_LOCK_GOMP_ALIGN 8
+
+// Lock behind omp_lock_t
+// State 0 is free, 1 is held and 2 is held with parked waiters.
+// It fits the 4 bytes libgomp reserves for omp_lock_t.
+struct mir_omp_lock_t { /*{{{*/
+    volatile int state;
+}; /*}}}*/
+
+// Lock of an atomic stripe, padded to its own cache line
+struct mir_omp_atomic_lock_t { /*{{{*/
+    struct mir_omp_lock_t lock;
+    char pad[MIR_OMP_ATOMIC_LOCK_SIZE - sizeof(struct mir_omp_lock_t)];
+}; /*}}}*/
+
+// Lock behind omp_nest_lock_t
+// The owner is the task holding the lock, count is the nesting depth.
+struct mir_omp_nest_lock_t { /*{{{*/
+    struct mir_omp_lock_t lock;
+    int count;
+    void* volatile owner;
+}; /*}}}*/
+
+void mir_omp_lock_init(omp_lock_t* lock);
+void mir_omp_lock_destroy(omp_lock_t* lock);
+void mir_omp_lock_set(omp_lock_t* lock);
+void mir_omp_lock_unset(omp_lock_t* lock);
+int mir_omp_lock_test(omp_lock_t* lock);
+
+void mir_omp_nest_lock_init(omp_nest_lock_t* lock);
+void mir_omp_nest_lock_destroy(omp_nest_lock_t* lock);
+void mir_omp_nest_lock_set(omp_nest_lock_t* lock);
+void mir_omp_nest_lock_unset(omp_nest_lock_t* lock);
+int mir_omp_nest_lock_test(omp_nest_lock_t* lock);
+
+void mir_omp_critical_start();
+void mir_omp_critical_end();
+void mir_omp_critical_name_start(void** pptr);
+void mir_omp_critical_name_end(void** pptr);
+
+void mir_omp_atomic_start(void* addr);
+void mir_omp_atomic_end(void* addr);
+
+END_C_DECLS
+
+#endif
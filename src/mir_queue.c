@@ -65,6 +65,30 @@ int mir_queue_push(struct mir_queue_t* queue, void* data)
     return 1;
 } /*}}}*/
 
+uint32_t mir_queue_push_many(struct mir_queue_t* queue, void** data, uint32_t num_data)
+{ /*{{{*/
+    MIR_ASSERT(queue != NULL);
+    MIR_ASSERT(data != NULL);
+
+    mir_lock_set(&(queue->enq_lock));
+
+    // Add as many as fit
+    uint32_t room = queue->capacity - queue->size;
+    uint32_t num_pushed = num_data < room ? num_data : room;
+    for (uint32_t i = 0; i < num_pushed; i++) {
+        MIR_ASSERT(data[i] != NULL);
+        queue->buffer[queue->in] = data[i];
+        queue->in++;
+        if (queue->in >= queue->capacity)
+            queue->in -= queue->capacity;
+    }
+    __sync_fetch_and_add(&(queue->size), num_pushed);
+
+    mir_lock_unset(&(queue->enq_lock));
+
+    return num_pushed;
+} /*}}}*/
+
 void mir_queue_pop(struct mir_queue_t* queue, void** data)
 { /*{{{*/
     MIR_ASSERT(queue != NULL);
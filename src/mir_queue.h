@@ -45,6 +45,9 @@ void mir_queue_destroy(struct mir_queue_t* queue);
 // Add an element to the queue
 int mir_queue_push(struct mir_queue_t* queue, void* data);
 
+// Add several elements to the queue. Returns the number added.
+uint32_t mir_queue_push_many(struct mir_queue_t* queue, void** data, uint32_t num_data);
+
 // Remove an element from the queue
 void mir_queue_pop(struct mir_queue_t* queue, void** data);
 
@@ -10,6 +10,11 @@
 #include "mir_defines.h"
 #include "mir_memory.h"
 #include "mir_mem_pol.h"
+#include "mir_task_queue.h"
+#include "mir_dep.h"
+#include "mir_fiber.h"
+#include "mir_team.h"
+#include "mir_loop.h"
 
 #ifdef MIR_GPL
 #define OMP_INIT omp_init();
@@ -28,6 +33,7 @@ uint32_t g_sig_worker_alive = 0;
 // Extern global data.
 extern uint64_t g_tasks_uidc;
 extern uint32_t g_num_tasks_waiting;
+extern uint32_t g_num_prio_tasks_waiting;
 extern uint32_t g_worker_status_board;
 extern uint64_t g_total_allocated_memory;
 
@@ -71,7 +77,13 @@ static void mir_preconfig_init(int num_workers)
     runtime->enable_recorder = 0;
     runtime->enable_ofp_handshake = 0;
     runtime->task_inlining_limit = MIR_INLINE_TASK_DURING_CREATION;
+    runtime->wait_depth_limit = MIR_WORKER_WAIT_DEPTH_LIMIT;
     runtime->idle_task = 0;
+    runtime->enable_task_deps = 0;
+    runtime->enable_adaptive_inlining = 0;
+    runtime->enable_task_coarsening = 0;
+    runtime->enable_fibers = 0;
+    runtime->fiber_stack_size = MIR_FIBER_STACK_SIZE;
 } /*}}}*/
 
 static void mir_postconfig_init()
@@ -87,6 +99,27 @@ static void mir_postconfig_init()
     runtime->sched_pol->create();
     MIR_DEBUG("Task scheduling policy set to %s.", runtime->sched_pol->name);
 
+    // Inlining would upset data-driven task placement
+    runtime->task_inlining_blocked = (0 == strcmp(runtime->sched_pol->name, "numa"));
+
+    // Injection queue for tasks submitted by non-worker threads
+    runtime->inject_queue = mir_task_queue_create(runtime->sched_pol->queue_capacity);
+
+    // Switching contexts interleaves tasks, which upsets per-worker recorder states
+    if (runtime->enable_fibers == 1 && runtime->enable_recorder == 1) {
+        MIR_LOG_INFO("Fibers are disabled when the recorder is enabled.");
+        runtime->enable_fibers = 0;
+    }
+    mir_omp_team_pool_create();
+    MIR_CHECK_MEM(runtime->inject_queue != NULL);
+    runtime->ext_twc = mir_twc_create();
+
+    // Data dependences
+    runtime->dep_domain = mir_dep_domain_create();
+
+    // Task groups
+    runtime->taskgroup = NULL;
+
     // Enable communication between outline function profiler and MIR
     if (runtime->enable_ofp_handshake == 1) {
         /*{{{*/
@@ -193,15 +226,21 @@ static inline void print_help()
                               "-s <str> (--schedule) task scheduling policy. Choose among central, central-stack, ws, ws-de and numa.\n"
                               "-m <str> (--memory-policy) memory allocation policy. Choose among coarse, fine and system.\n"
                               "--inlining-limit=<int> task inlining limit based on number of tasks per worker.\n"
-                              "--stack-size=<int> worker stack size in MB\n"
+                              "--stack-size=<int> worker and fiber stack size in MB\n"
+                              "--wait-depth=<int> nesting depth of task waits beyond which waiting workers look for descendant tasks first\n"
                               "--queue-size=<int> task queue capacity\n"
                               "--numa-footprint=<int> for numa scheduling policy. Indicates data footprint size in bytes below which task is dealt to worker's private queue.\n"
                               "--single-parallel-block run parallel blocks with one worker\n"
                               "--precomp_schedule_dir <str> location of precomputed schedules for for-loops. \n"
+                              "--loop-schedule=<str> schedule of for-loops with schedule(runtime), as kind[,chunk]. Choose among static, dynamic, guided, auto, adaptive, affinity and numa.\n"
                               "--worker-stats collect worker statistics\n"
                               "--task-stats collect task statistics\n"
                               "--chunks-are-tasks treat loop chunks as tasks\n"
                               "--idle-task idle context is a task\n"
+                              "--task-deps hold tasks until sibling tasks with overlapping data footprints are done\n"
+                              "--adaptive-inlining inline tasks of functions measured to be too small to pay for their overhead\n"
+                              "--task-coarsening bundle consecutive tiny sibling tasks into tasks executed serially\n"
+                              "--fibers suspend waiting tasks and let the worker continue on another stack\n"
                               "-r (--recorder) enable worker recorder\n"
                               "-p (--profiler) enable communication with Outline Function Profiler. Note: This option is supported only for single-worker execution!\n");
 } /*}}}*/
@@ -247,9 +286,11 @@ static void mir_config()
             { "schedule", required_argument, 0, 's' },
             { "memory-policy", required_argument, 0, 'm' },
             { "stack-size", required_argument, 0, 0 },
+            { "wait-depth", required_argument, 0, 0 },
             { "inlining-limit", required_argument, 0, 0 },
             { "single-parallel-block", no_argument, 0, 0 },
             { "precomp-schedule-dir", required_argument, 0, 0},
+            { "loop-schedule", required_argument, 0, 0 },
             { "numa-footprint", required_argument, 0, 0 },
             { "queue-size", required_argument, 0, 0 },
             { "help", no_argument, 0, 'h' },
@@ -259,6 +300,10 @@ static void mir_config()
             { "task-stats", no_argument, 0, 0 },
             { "chunks-are-tasks", no_argument, 0, 0 },
             { "idle-task", no_argument, 0, 0 },
+            { "task-deps", no_argument, 0, 0 },
+            { "adaptive-inlining", no_argument, 0, 0 },
+            { "task-coarsening", no_argument, 0, 0 },
+            { "fibers", no_argument, 0, 0 },
             { 0, 0, 0, 0 }
         };
 
@@ -299,7 +344,23 @@ static void mir_config()
                 int ps_sz = atoi(optarg) * 1024 * 1024;
                 MIR_ASSERT_STR(ps_sz > 0, "Stack size should be greater than 0.");
                 MIR_ASSERT_STR(0 == mir_pstack_set_size(ps_sz), "Call to mir_pstack_set_size failed.");
-                MIR_DEBUG("Process stack size set to %d bytes.", ps_sz);
+                runtime->fiber_stack_size = ps_sz;
+                MIR_DEBUG("Process and fiber stack size set to %d bytes.", ps_sz);
+            }
+            else if (0 == strcmp(long_options[option_index].name, "wait-depth")) {
+                int depth = atoi(optarg);
+                MIR_ASSERT_STR(depth > 0, "Wait depth limit should be greater than 0.");
+                runtime->wait_depth_limit = depth;
+                MIR_DEBUG("Wait depth limit set to %d.", depth);
+            }
+            else if (0 == strcmp(long_options[option_index].name, "loop-schedule")) {
+#ifdef MIR_GPL
+                if (0 != mir_omp_loop_schedule_parse(optarg, &runtime->omp_for_schedule, &runtime->omp_for_chunk_size))
+                    MIR_LOG_ERR("Loop schedule %s is not valid.", optarg);
+                MIR_DEBUG("Loop schedule set to %s.", optarg);
+#else
+                MIR_LOG_ERR("MIR built without OpenMP support.");
+#endif
             }
             else if (0 == strcmp(long_options[option_index].name, "worker-stats")) {
                 runtime->enable_worker_stats = 1;
@@ -321,6 +382,22 @@ static void mir_config()
                 runtime->idle_task = 1;
                 MIR_DEBUG("Idle context is a task enabled.");
             }
+            else if (0 == strcmp(long_options[option_index].name, "task-deps")) {
+                runtime->enable_task_deps = 1;
+                MIR_DEBUG("Task data dependence resolution is enabled.");
+            }
+            else if (0 == strcmp(long_options[option_index].name, "adaptive-inlining")) {
+                runtime->enable_adaptive_inlining = 1;
+                MIR_DEBUG("Adaptive task inlining is enabled.");
+            }
+            else if (0 == strcmp(long_options[option_index].name, "task-coarsening")) {
+                runtime->enable_task_coarsening = 1;
+                MIR_DEBUG("Task coarsening is enabled.");
+            }
+            else if (0 == strcmp(long_options[option_index].name, "fibers")) {
+                runtime->enable_fibers = 1;
+                MIR_DEBUG("Fiber-based task execution is enabled.");
+            }
             else if (0 == strcmp(long_options[option_index].name, "queue-size")) {
                 runtime->sched_pol->queue_capacity = atoi(optarg);
                 MIR_ASSERT_STR(runtime->sched_pol->queue_capacity > 0, "Queue capacity should be greater than 0.");
@@ -480,6 +557,11 @@ void mir_destroy()
         return;
     }
 
+    // Schedule tiny tasks gathered so far
+    struct mir_worker_t* this_worker = mir_worker_try_get_context();
+    if (this_worker)
+        mir_task_bundle_flush(this_worker);
+
     if(runtime->idle_task) {
         // Get idle task
         struct mir_task_t* task = mir_worker_get_context()->current_task;
@@ -494,6 +576,13 @@ void mir_destroy()
     MIR_ASSERT(strlen(temp) < (MIR_RECORDER_EVENT_META_DATA_MAX_SIZE - 1));
     MIR_RECORDER_EVENT(temp, strlen(temp));
 
+    // Wait for tasks submitted by non-worker threads
+    MIR_DEBUG("Waiting for submitted tasks ...");
+    if (this_worker)
+        mir_task_wait_cond(this_worker, mir_twc_done, runtime->ext_twc, runtime->ext_twc);
+    while (mir_twc_reduce(runtime->ext_twc) != 1)
+        __sync_synchronize();
+
     // Check if workers are free
     MIR_DEBUG("Checking if workers are done ...");
     mir_worker_check_done();
@@ -587,6 +676,16 @@ dead:
     // Deinit scheduling policy
     MIR_DEBUG("Stopping scheduler ...");
     runtime->sched_pol->destroy();
+    mir_task_queue_destroy(runtime->inject_queue);
+    runtime->inject_queue = NULL;
+    mir_twc_destroy(runtime->ext_twc);
+    runtime->ext_twc = NULL;
+    mir_dep_domain_destroy(runtime->dep_domain);
+    runtime->dep_domain = NULL;
+    mir_fiber_pool_destroy();
+    mir_omp_team_pool_destroy();
+    mir_omp_loop_affinity_destroy();
+    mir_omp_loop_precomp_destroy();
 
     // Deinit architecture
     MIR_DEBUG("Releasing architecture memory ...");
@@ -607,6 +706,7 @@ shutdown:
     runtime = NULL;
     g_sig_worker_alive = 0;
     g_num_tasks_waiting = 0;
+    g_num_prio_tasks_waiting = 0;
     g_tasks_uidc = MIR_TASK_ID_START;
     g_worker_status_board = 0;
     g_total_allocated_memory = 0;
@@ -23,10 +23,20 @@ struct mir_runtime_t { /*{{{*/
     struct mir_sched_pol_t* sched_pol;
     struct mir_arch_t* arch;
     uint32_t task_inlining_limit;
+    uint32_t wait_depth_limit;
+    size_t fiber_stack_size;
+    int task_inlining_blocked; // The policy places tasks by data
     int ofp_shmid;
     char* ofp_shm;
     struct mir_twc_t* ctwc;
     unsigned int num_children_tasks;
+    // Tasks submitted by threads outside the runtime
+    struct mir_task_queue_t* inject_queue;
+    struct mir_twc_t* ext_twc;
+    // Dependences among tasks without a parent
+    struct mir_dep_domain_t* dep_domain;
+    // Innermost task group open outside tasks
+    struct mir_taskgroup_t* taskgroup;
 
     // Initialization control
     int init_count;
@@ -34,6 +44,8 @@ struct mir_runtime_t { /*{{{*/
 
 #ifdef MIR_GPL
     // OpenMP support
+    // Deprecated. Kept for the OpenMP shim until it drops its critical
+    // ... section and atomic entry points, which the runtime defines.
     struct mir_lock_t omp_critsec_lock;
     struct mir_lock_t omp_atomic_lock;
     enum omp_for_schedule_t omp_for_schedule;
@@ -50,6 +62,10 @@ struct mir_runtime_t { /*{{{*/
     int enable_recorder;
     int enable_ofp_handshake;
     int idle_task;
+    int enable_task_deps;
+    int enable_adaptive_inlining;
+    int enable_task_coarsening;
+    int enable_fibers;
 }; /*}}}*/
 
 extern struct mir_runtime_t* runtime;
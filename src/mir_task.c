@@ -10,6 +10,7 @@
 #include "mir_task_queue.h"
 #include "mir_loop.h"
 #include "mir_mem_pol.h"
+#include "mir_fiber.h"
 
 #include <stdint.h>
 #include <stdlib.h>
@@ -21,19 +22,28 @@ extern uint32_t g_num_tasks_waiting;
 // FIXME: Make these per-worker
 uint64_t g_tasks_uidc = MIR_TASK_ID_START;
 
-static inline unsigned int mir_twc_reduce(struct mir_twc_t* twc)
+// Workers that last wrote data footprint base addresses
+// Direct-mapped. Collisions overwrite, which is fine for hints.
+struct mir_task_producer_t { /*{{{*/
+    const void* addr;
+    int worker;
+}; /*}}}*/
+static struct mir_task_producer_t g_task_producers[1 << MIR_TASK_PRODUCER_TABLE_BITS];
+
+static inline struct mir_task_producer_t* mir_task_producer_slot(const void* addr)
 { /*{{{*/
-    volatile unsigned long sum = 0;
-    for (int i = 0; i < runtime->num_workers; i++)
-        sum += twc->count_per_worker[i];
+    uint64_t key = (uint64_t)(uintptr_t)addr * 11400714819323198485ull;
+    return &g_task_producers[key >> (64 - MIR_TASK_PRODUCER_TABLE_BITS)];
+} /*}}}*/
 
-    // This catches the nasty case of not sychronizing with all tasks previously
-    MIR_ASSERT(sum <= twc->count);
+int mir_task_producer_of(const void* addr)
+{ /*{{{*/
+    struct mir_task_producer_t* slot = mir_task_producer_slot(addr);
+    int worker = slot->worker;
+    if (slot->addr != addr || worker >= runtime->num_workers)
+        return -1;
 
-    if (sum < twc->count)
-        return 0;
-    else
-        return 1; // sum == twc->count
+    return worker;
 } /*}}}*/
 
 static inline uint64_t elapsed_execution_time(struct mir_task_t* task)
@@ -42,8 +52,86 @@ static inline uint64_t elapsed_execution_time(struct mir_task_t* task)
     return task->exec_cycles + (mir_get_cycles() - task->exec_resume_instant);
 } /*}}}*/
 
-static inline int inline_necessary()
+// Granularity statistics of a task function
+// Updated without locks. Races only lose samples.
+struct mir_task_gran_t { /*{{{*/
+    mir_tfunc_t func;
+    uint32_t num_samples;
+    uint32_t num_inlined;
+    uint64_t exec_cycles; // Moving average
+    uint64_t overhead_cycles; // Moving average of creation and scheduling cost
+}; /*}}}*/
+static struct mir_task_gran_t g_task_gran[1 << MIR_TASK_GRAN_TABLE_BITS];
+
+static inline struct mir_task_gran_t* mir_task_gran_slot(mir_tfunc_t func)
+{ /*{{{*/
+    uint64_t h = ((uint64_t)(uintptr_t)func) * 11400714819323198485ull;
+    return &g_task_gran[h >> (64 - MIR_TASK_GRAN_TABLE_BITS)];
+} /*}}}*/
+
+static inline void mir_task_gran_sample(struct mir_task_t* task, uint64_t overhead_cycles)
+{ /*{{{*/
+    struct mir_task_gran_t* slot = mir_task_gran_slot(task->func);
+
+    // Evict the previous function on collision
+    if (slot->func != task->func) {
+        slot->func = task->func;
+        slot->num_samples = 0;
+        slot->num_inlined = 0;
+    }
+
+    if (slot->num_samples == 0) {
+        slot->exec_cycles = task->exec_cycles;
+        slot->overhead_cycles = overhead_cycles;
+    }
+    else {
+        slot->exec_cycles += ((int64_t)task->exec_cycles - (int64_t)slot->exec_cycles) >> MIR_TASK_GRAN_EWMA_SHIFT;
+        slot->overhead_cycles += ((int64_t)overhead_cycles - (int64_t)slot->overhead_cycles) >> MIR_TASK_GRAN_EWMA_SHIFT;
+    }
+    slot->num_samples++;
+} /*}}}*/
+
+static inline void mir_task_gran_sample_exec(mir_tfunc_t func, uint64_t exec_cycles)
+{ /*{{{*/
+    // Bundled tasks have no overhead of their own to sample
+    struct mir_task_gran_t* slot = mir_task_gran_slot(func);
+    if (slot->func == func && slot->num_samples > 0)
+        slot->exec_cycles += ((int64_t)exec_cycles - (int64_t)slot->exec_cycles) >> MIR_TASK_GRAN_EWMA_SHIFT;
+} /*}}}*/
+
+static inline int mir_task_gran_enabled()
+{ /*{{{*/
+    return runtime->enable_adaptive_inlining == 1 || runtime->enable_task_coarsening == 1;
+} /*}}}*/
+
+static inline int mir_task_gran_is_small(struct mir_task_gran_t* slot, mir_tfunc_t func)
 { /*{{{*/
+    if (slot->func != func || slot->num_samples < MIR_TASK_GRAN_MIN_SAMPLES)
+        return 0;
+
+    return slot->exec_cycles < MIR_TASK_GRAN_OVERHEAD_FACTOR * slot->overhead_cycles;
+} /*}}}*/
+
+static inline int mir_task_gran_too_small(mir_tfunc_t func)
+{ /*{{{*/
+    struct mir_task_gran_t* slot = mir_task_gran_slot(func);
+    if (mir_task_gran_is_small(slot, func) == 0)
+        return 0;
+
+    // Create a task now and then to follow changes in task size
+    if ((++slot->num_inlined % MIR_TASK_GRAN_RESAMPLE_INTERVAL) == 0)
+        return 0;
+
+    return 1;
+} /*}}}*/
+
+static inline int inline_necessary(mir_tfunc_t func)
+{ /*{{{*/
+    // Inline small tasks while other workers have enough work
+    if (runtime->enable_adaptive_inlining == 1 && runtime->task_inlining_blocked == 0)
+        if (g_num_tasks_waiting >= runtime->num_workers && mir_task_gran_too_small(func) == 1)
+            return 1;
+
     if (runtime->task_inlining_limit == 0)
         return 0;
 
@@ -53,7 +141,7 @@ static inline int inline_necessary()
     if (runtime->task_inlining_limit == 1)
         return 1;
 
-    if (0 == strcmp(runtime->sched_pol->name, "numa"))
+    if (runtime->task_inlining_blocked == 1)
         return 0;
 
     if ((g_num_tasks_waiting / runtime->num_workers) >= runtime->task_inlining_limit)
@@ -72,21 +160,11 @@ struct mir_task_t* mir_task_create_twin(char *name, struct mir_task_t* task, cha
     return twin;
 }/*}}}*/
 
-struct mir_task_t* mir_task_create_common(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, const struct mir_data_footprint_t* data_footprints, const char* name, struct mir_omp_team_t* myteam, struct mir_loop_des_t* loopdes, struct mir_task_t* parent)
-{ /*{{{*/
-    MIR_ASSERT(tfunc != NULL);
-
-    // Overhead measurement
-    uint64_t start_instant = mir_get_cycles();
-
-    struct mir_task_t* task;
-#ifdef MIR_TASK_ALLOCATE_ON_STACK
-    task = alloca(sizeof(struct mir_task_t));
-#else
-    task = mir_malloc_int(sizeof(struct mir_task_t));
-#endif
-    MIR_CHECK_MEM(task != NULL);
+// The function mir_task_init() sets up a task except for book-keeping
+// ... shared with siblings, such as ids and wait counts.
 
+static inline void mir_task_init(struct mir_task_t* task, mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, const struct mir_data_footprint_t* data_footprints, const char* name, struct mir_omp_team_t* myteam, struct mir_loop_des_t* loopdes, struct mir_task_t* parent)
+{ /*{{{*/
     // Task function and argument data
     task->func = tfunc;
     task->data_size = data_size;
@@ -103,10 +181,6 @@ struct mir_task_t* mir_task_create_common(mir_tfunc_t tfunc, void* data, size_t
     else
         task->data = data;
 
-    // Task unique id
-    // A running number
-    task->id.uid = __sync_fetch_and_add(&(g_tasks_uidc), 1);
-
     // Task name
     MIR_ASSERT(strlen(MIR_TASK_DEFAULT_NAME) < MIR_SHORT_NAME_LEN);
     strcpy(task->name, MIR_TASK_DEFAULT_NAME);
@@ -151,33 +225,85 @@ struct mir_task_t* mir_task_create_common(mir_tfunc_t tfunc, void* data, size_t
     // For children
     task->ctwc = mir_twc_create();
     // Link to parent wait counter
+    // Tasks submitted by non-worker threads are not synchronized by mir_task_wait()
     if (parent)
         task->twc = parent->ctwc;
+    else if (mir_worker_try_get_context() == NULL)
+        task->twc = runtime->ext_twc;
     else
         task->twc = runtime->ctwc;
-    __sync_fetch_and_add(&(task->twc->count), 1);
 
     // Task children book-keeping
     task->num_children = 0;
     task->child_number = 0;
-    if (parent) {
-        __sync_fetch_and_add(&(parent->num_children), 1);
-        task->child_number = parent->num_children;
-    }
-    else {
-        __sync_fetch_and_add(&(runtime->num_children_tasks), 1);
-        task->child_number = runtime->num_children_tasks;
-    }
 
     // Other book-keeping
     task->queue_size_at_pop = 0;
 
+    // Scheduling attributes
+    task->priority = 0;
+    task->affinity_worker = -1;
+    task->affinity_node = -1;
+
     // Flags
     task->done = 0;
     task->taken = 0;
+    task->handle = NULL;
+    task->future = NULL;
+
+    // Task groups
+    // Members of a group create members of the same group
+    task->taskgroup = NULL;
+    if (parent)
+        task->taskgroup = parent->child_taskgroup;
+    else if (mir_worker_try_get_context() != NULL)
+        task->taskgroup = runtime->taskgroup;
+    task->child_taskgroup = task->taskgroup;
+
+    // Data dependences
+    task->dep = NULL;
+    task->dep_domain = NULL;
 
     // Create loop structure to support GOMP_loop_*_start.
     task->loop = loopdes;
+    task->loop_base = NULL;
+    task->loop_stride = 0;
+} /*}}}*/
+
+struct mir_task_t* mir_task_create_common(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, const struct mir_data_footprint_t* data_footprints, const char* name, struct mir_omp_team_t* myteam, struct mir_loop_des_t* loopdes, struct mir_task_t* parent)
+{ /*{{{*/
+    MIR_ASSERT(tfunc != NULL);
+
+    // Overhead measurement
+    uint64_t start_instant = mir_get_cycles();
+
+    struct mir_task_t* task;
+#ifdef MIR_TASK_ALLOCATE_ON_STACK
+    task = alloca(sizeof(struct mir_task_t));
+#else
+    task = mir_malloc_int(sizeof(struct mir_task_t));
+#endif
+    MIR_CHECK_MEM(task != NULL);
+
+    mir_task_init(task, tfunc, data, data_size, num_data_footprints, data_footprints, name, myteam, loopdes, parent);
+
+    // Task unique id
+    // A running number
+    task->id.uid = __sync_fetch_and_add(&(g_tasks_uidc), 1);
+
+    // Wait counters and children book-keeping
+    __sync_fetch_and_add(&(task->twc->count), 1);
+    if (parent) {
+        __sync_fetch_and_add(&(parent->num_children), 1);
+        task->child_number = parent->num_children;
+    }
+    else {
+        __sync_fetch_and_add(&(runtime->num_children_tasks), 1);
+        task->child_number = runtime->num_children_tasks;
+    }
+
+    // Task groups
+    mir_taskgroup_add(task->taskgroup);
 
     // Creation cost
     task->creation_cycles = (mir_get_cycles() - start_instant);
@@ -213,7 +339,7 @@ void mir_task_schedule_on_worker(struct mir_task_t* task, int workerid)
 
     if (workerid < 0) {
         // Push task to the scheduling policy
-        pushed = runtime->sched_pol->push(worker, task);
+        pushed = mir_worker_schedule(worker, task);
     }
     else {
         struct mir_worker_t* to_worker = &runtime->workers[workerid];
@@ -231,24 +357,259 @@ void mir_task_schedule_on_worker(struct mir_task_t* task, int workerid)
     T_DBG("Sb", task);
 } /*}}}*/
 
-void mir_task_create(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name)
+void mir_task_apply_attr(struct mir_task_t* task, const struct mir_task_attr_t* attr)
+{ /*{{{*/
+    MIR_ASSERT(task != NULL);
+
+    if (attr == NULL)
+        return;
+
+    MIR_ASSERT_STR(attr->priority >= 0, "Task priority cannot be negative.");
+    task->priority = attr->priority < MIR_TASK_PRIORITY_LEVELS ? attr->priority : MIR_TASK_PRIORITY_LEVELS - 1;
+
+    // Affinity hints
+    int worker = attr->worker;
+    if (worker < 0 && attr->node < 0 && attr->near != NULL)
+        worker = mir_task_producer_of(attr->near);
+    if (worker >= 0) {
+        MIR_ASSERT_STR(worker < runtime->num_workers, "Preferred worker %d does not exist.", worker);
+        task->affinity_node = runtime->arch->node_of(runtime->workers[worker].cpu_id);
+        // Addresses only hint at the node
+        if (attr->worker >= 0)
+            task->affinity_worker = worker;
+    }
+    else if (attr->node >= 0) {
+        MIR_ASSERT_STR(attr->node < runtime->arch->num_nodes, "Preferred node %d does not exist.", attr->node);
+        task->affinity_node = attr->node;
+    }
+} /*}}}*/
+
+static struct mir_task_handle_t* mir_task_submit_int(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name, const struct mir_task_attr_t* attr, int need_handle)
 { /*{{{*/
     MIR_ASSERT(tfunc != NULL);
+    MIR_ASSERT_STR(runtime != NULL, "Tasks cannot be submitted before the runtime system is created.");
+
+    // Create task
+    struct mir_task_t* task = mir_task_create_common(tfunc, data, data_size, num_data_footprints, data_footprints, name, NULL, NULL, NULL);
+    MIR_CHECK_MEM(task != NULL);
+    mir_task_apply_attr(task, attr);
+
+    // Create handle
+    struct mir_task_handle_t* handle = NULL;
+    if (need_handle) {
+        handle = mir_malloc_int(sizeof(struct mir_task_handle_t));
+        MIR_CHECK_MEM(handle != NULL);
+        handle->task = task;
+        handle->done = 0;
+        pthread_mutex_init(&handle->lock, NULL);
+        pthread_cond_init(&handle->cond, NULL);
+        task->handle = handle;
+    }
+
+    // Inject task
+    // Workers drain the injection queue
+    if (0 == mir_task_queue_push(runtime->inject_queue, task))
+        MIR_LOG_ERR("Cannot enque task into injection queue. Increase queue capacity using MIR_CONF.");
+    __sync_fetch_and_add(&g_num_tasks_waiting, 1);
+    T_DBG("Sb", task);
 
-    mir_task_create_on_worker(tfunc, data, data_size, num_data_footprints,
-                              data_footprints, name, NULL, NULL, -1);
+    return handle;
 } /*}}}*/
 
-void mir_task_create_on_worker(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name, struct mir_omp_team_t* myteam, struct mir_loop_des_t* loopdes, int workerid)
+struct mir_task_handle_t* mir_task_submit(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name)
+{ /*{{{*/
+    return mir_task_submit_int(tfunc, data, data_size, num_data_footprints, data_footprints, name, NULL, 1);
+} /*}}}*/
+
+int mir_task_handle_test(struct mir_task_handle_t* handle)
+{ /*{{{*/
+    MIR_ASSERT(handle != NULL);
+
+    return handle->done == 1;
+} /*}}}*/
+
+static int mir_task_handle_done(void* arg)
+{ /*{{{*/
+    return mir_task_handle_test((struct mir_task_handle_t*)arg);
+} /*}}}*/
+
+void mir_task_handle_wait(struct mir_task_handle_t* handle)
+{ /*{{{*/
+    MIR_ASSERT(handle != NULL);
+
+    // Workers do useful work while waiting
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    if (worker) {
+        mir_task_wait_cond(worker, mir_task_handle_done, handle, NULL);
+        return;
+    }
+
+    // Other threads spin for a while, then block
+    for (int i = 0; i < MIR_TASK_HANDLE_SPIN_COUNT; i++) {
+        if (handle->done == 1)
+            return;
+        __sync_synchronize();
+    }
+
+    pthread_mutex_lock(&handle->lock);
+    while (handle->done == 0)
+        pthread_cond_wait(&handle->cond, &handle->lock);
+    pthread_mutex_unlock(&handle->lock);
+} /*}}}*/
+
+void mir_task_handle_destroy(struct mir_task_handle_t* handle)
+{ /*{{{*/
+    MIR_ASSERT(handle != NULL);
+    MIR_ASSERT_STR(handle->done == 1, "Cannot destroy handle of a task that is not done.");
+
+    // Waiters return as soon as they see done, possibly while the
+    // ... signaling worker still holds the lock
+    pthread_mutex_lock(&handle->lock);
+    pthread_mutex_unlock(&handle->lock);
+
+    pthread_mutex_destroy(&handle->lock);
+    pthread_cond_destroy(&handle->cond);
+    mir_free_int(handle, sizeof(struct mir_task_handle_t));
+} /*}}}*/
+
+static inline void mir_task_handle_signal(struct mir_task_handle_t* handle)
+{ /*{{{*/
+    MIR_ASSERT(handle != NULL);
+
+    pthread_mutex_lock(&handle->lock);
+    handle->done = 1;
+    pthread_cond_broadcast(&handle->cond);
+    pthread_mutex_unlock(&handle->lock);
+} /*}}}*/
+
+void mir_task_attr_init(struct mir_task_attr_t* attr)
+{ /*{{{*/
+    MIR_ASSERT(attr != NULL);
+
+    attr->priority = 0;
+    attr->worker = -1;
+    attr->node = -1;
+    attr->near = NULL;
+} /*}}}*/
+
+static void* mir_task_bundle_execute(void* arg)
+{ /*{{{*/
+    struct mir_task_bundle_t* bundle = *(struct mir_task_bundle_t**)arg;
+    MIR_ASSERT(bundle != NULL);
+
+    // Run members in creation order
+    // Their cost keeps the bundle size estimate fresh
+    int measure = mir_task_gran_enabled();
+    for (uint32_t i = 0; i < bundle->num_tasks; i++) {
+        struct mir_task_bundle_entry_t* entry = &bundle->entries[i];
+        uint64_t start = measure ? mir_get_cycles() : 0;
+        entry->func(&bundle->data[entry->data_offset]);
+        if (measure)
+            mir_task_gran_sample_exec(entry->func, mir_get_cycles() - start);
+    }
+
+    mir_free_int(bundle, sizeof(struct mir_task_bundle_t));
+
+    return NULL;
+} /*}}}*/
+
+void mir_task_bundle_flush(struct mir_worker_t* worker)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+
+    struct mir_task_bundle_t* bundle = worker->bundle;
+    if (bundle == NULL)
+        return;
+    worker->bundle = NULL;
+
+    T_DBG("Bf", bundle->task);
+    mir_task_schedule_on_worker(bundle->task, -1);
+} /*}}}*/
+
+// The function mir_task_bundle_add() gathers a tiny task into the open bundle
+// ... of the worker. It returns 0 if the task must be created as usual.
+
+static inline int mir_task_bundle_add(struct mir_worker_t* worker, mir_tfunc_t tfunc, void* data, size_t data_size)
+{ /*{{{*/
+    // Small tasks only
+    struct mir_task_gran_t* slot = mir_task_gran_slot(tfunc);
+    if (mir_task_gran_is_small(slot, tfunc) == 0)
+        return 0;
+
+    size_t aligned_size = (data_size + 15) & ~((size_t)15);
+    if (aligned_size > MIR_TASK_BUNDLE_DATA_SIZE)
+        return 0;
+
+    // Bundles hold siblings of one group only
+    struct mir_task_bundle_t* bundle = worker->bundle;
+    if (bundle && (bundle->task->parent != worker->current_task ||
+                   bundle->task->taskgroup != mir_taskgroup_current() ||
+                   bundle->data_used + aligned_size > MIR_TASK_BUNDLE_DATA_SIZE)) {
+        mir_task_bundle_flush(worker);
+        bundle = NULL;
+    }
+
+    if (bundle == NULL) {
+        bundle = mir_malloc_int(sizeof(struct mir_task_bundle_t));
+        MIR_CHECK_MEM(bundle != NULL);
+        bundle->num_tasks = 0;
+        bundle->data_used = 0;
+
+        // Enough tasks to pay for the overhead of one
+        uint64_t exec_cycles = slot->exec_cycles > 0 ? slot->exec_cycles : 1;
+        uint64_t target = (MIR_TASK_GRAN_OVERHEAD_FACTOR * slot->overhead_cycles + exec_cycles - 1) / exec_cycles;
+        if (target < 2)
+            target = 2;
+        if (target > MIR_TASK_BUNDLE_MAX_SIZE)
+            target = MIR_TASK_BUNDLE_MAX_SIZE;
+        bundle->target_size = target;
+
+        // The bundle task counts as a child now, so waits cover its members
+        bundle->task = mir_task_create_common((mir_tfunc_t)mir_task_bundle_execute, &bundle, sizeof(struct mir_task_bundle_t*), 0, NULL, MIR_TASK_BUNDLE_NAME, NULL, NULL, worker->current_task);
+        MIR_CHECK_MEM(bundle->task != NULL);
+
+        worker->bundle = bundle;
+    }
+
+    // Copy task data
+    struct mir_task_bundle_entry_t* entry = &bundle->entries[bundle->num_tasks];
+    entry->func = tfunc;
+    entry->data_offset = bundle->data_used;
+    if (data_size > 0)
+        memcpy(&bundle->data[bundle->data_used], data, data_size);
+    bundle->data_used += aligned_size;
+    bundle->num_tasks++;
+
+    // Update worker stats
+    if (runtime->enable_worker_stats == 1)
+        worker->statistics->num_tasks_bundled++;
+
+    if (bundle->num_tasks >= bundle->target_size)
+        mir_task_bundle_flush(worker);
+
+    return 1;
+} /*}}}*/
+
+static void mir_task_create_on_worker_int(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name, struct mir_omp_team_t* myteam, struct mir_loop_des_t* loopdes, int workerid, const struct mir_task_attr_t* attr, struct mir_future_t* future)
 { /*{{{*/
+    // Tasks with dependences cannot be inlined
+    int resolve_deps = runtime->enable_task_deps == 1 && num_data_footprints > 0;
+
     // To inline or not to line, that is the grand question!
-    if (workerid < 0 && inline_necessary() == 1) {
+    if (workerid < 0 && resolve_deps == 0 && inline_necessary(tfunc) == 1) {
         MIR_CONTEXT_EXIT;
 
-        tfunc(data);
+        void* value = tfunc(data);
 
         MIR_CONTEXT_ENTER;
 
+        // Inlined futures are ready at once
+        if (future) {
+            future->task = NULL;
+            future->value = value;
+            future->done = 1;
+        }
+
         // Update worker stats
         if (runtime->enable_worker_stats == 1) {
             struct mir_worker_t* worker = mir_worker_get_context();
@@ -265,9 +626,32 @@ void mir_task_create_on_worker(mir_tfunc_t tfunc, void* data, size_t data_size,
     struct mir_worker_t* worker = mir_worker_get_context();
     MIR_ASSERT(worker != NULL);
 
+    // Coarsen plain tiny tasks into bundles
+    if (runtime->enable_task_coarsening == 1 && runtime->task_inlining_blocked == 0 &&
+        workerid < 0 && num_data_footprints == 0 && myteam == NULL && loopdes == NULL && attr == NULL && future == NULL &&
+        mir_task_bundle_add(worker, tfunc, data, data_size) == 1) {
+        MIR_RECORDER_STATE_END(NULL, 0);
+        return;
+    }
+
     // Create task
     struct mir_task_t* task = mir_task_create_common(tfunc, data, data_size, num_data_footprints, data_footprints, name, myteam, loopdes, worker->current_task);
     MIR_CHECK_MEM(task != NULL);
+    mir_task_apply_attr(task, attr);
+    task->future = future;
+    if (future) {
+        // Continuations attach to the dependence state
+        future->task = task;
+        if (task->dep == NULL)
+            task->dep = mir_dep_create();
+    }
+
+    // Hold task until sibling tasks it depends on are done
+    if (resolve_deps == 1 && mir_dep_register(task) == 0) {
+        T_DBG("Hd", task);
+        MIR_RECORDER_STATE_END(NULL, 0);
+        return;
+    }
 
     // Schedule task
     mir_task_schedule_on_worker(task, workerid);
@@ -275,6 +659,305 @@ void mir_task_create_on_worker(mir_tfunc_t tfunc, void* data, size_t data_size,
     MIR_RECORDER_STATE_END(NULL, 0);
 } /*}}}*/
 
+void mir_task_create(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name)
+{ /*{{{*/
+    mir_task_create_attr(tfunc, data, data_size, num_data_footprints, data_footprints, name, NULL);
+} /*}}}*/
+
+void mir_task_create_attr(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name, const struct mir_task_attr_t* attr)
+{ /*{{{*/
+    MIR_ASSERT(tfunc != NULL);
+
+    // Non-worker threads submit through the injection queue
+    if (mir_worker_try_get_context() == NULL) {
+        mir_task_submit_int(tfunc, data, data_size, num_data_footprints, data_footprints, name, attr, 0);
+        return;
+    }
+
+    mir_task_create_on_worker_int(tfunc, data, data_size, num_data_footprints,
+                                  data_footprints, name, NULL, NULL, -1, attr, NULL);
+} /*}}}*/
+
+// The function mir_task_create_counted() creates a child of the current task
+// ... whose completion is counted by twc instead of the child wait counter of
+// ... the current task. Waiting on twc then waits for exactly these tasks.
+
+void mir_task_create_counted(mir_tfunc_t tfunc, void* data, size_t data_size, const char* name, struct mir_twc_t* twc, const struct mir_task_attr_t* attr)
+{ /*{{{*/
+    MIR_ASSERT(tfunc != NULL);
+    MIR_ASSERT(twc != NULL);
+
+    MIR_RECORDER_STATE_BEGIN(MIR_STATE_TCREATE);
+
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT(worker != NULL);
+
+    struct mir_task_t* task = mir_task_create_common(tfunc, data, data_size, 0, NULL, name, NULL, NULL, worker->current_task);
+    MIR_CHECK_MEM(task != NULL);
+    mir_task_apply_attr(task, attr);
+
+    // Move the count over to twc
+    // Only the current task waits on its child counter, and it is busy here.
+    __sync_fetch_and_sub(&(task->twc->count), 1);
+    task->twc = twc;
+    __sync_fetch_and_add(&(twc->count), 1);
+
+    mir_task_schedule_on_worker(task, -1);
+
+    MIR_RECORDER_STATE_END(NULL, 0);
+} /*}}}*/
+
+// The function mir_task_create_siblings() creates num_tasks children of the
+// ... current task without scheduling them. Argument block i starts at
+// ... data + i * data_stride. Tasks are allocated in one block and
+// ... book-keeping is reserved with single atomics.
+
+void mir_task_create_siblings(mir_tfunc_t tfunc, void* data, size_t data_size, size_t data_stride, unsigned int num_tasks, const char* name, struct mir_omp_team_t* myteam, struct mir_task_t** tasks)
+{ /*{{{*/
+    MIR_ASSERT(tfunc != NULL);
+    MIR_ASSERT(tasks != NULL);
+    MIR_ASSERT(num_tasks > 0);
+
+    // Overhead measurement
+    uint64_t start_instant = mir_get_cycles();
+
+    // Get this worker
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT(worker != NULL);
+    struct mir_task_t* parent = worker->current_task;
+
+    // Allocate all tasks in one block
+    struct mir_task_t* block = mir_malloc_int(num_tasks * sizeof(struct mir_task_t));
+    MIR_CHECK_MEM(block != NULL);
+
+    // Reserve ids and child numbers
+    uint64_t first_uid = __sync_fetch_and_add(&(g_tasks_uidc), num_tasks);
+    unsigned int first_child;
+    if (parent)
+        first_child = __sync_fetch_and_add(&(parent->num_children), num_tasks);
+    else
+        first_child = __sync_fetch_and_add(&(runtime->num_children_tasks), num_tasks);
+
+    for (unsigned int i = 0; i < num_tasks; i++) {
+        struct mir_task_t* task = &block[i];
+        mir_task_init(task, tfunc, data_size > 0 ? (char*)data + i * data_stride : data, data_size, 0, NULL, name, myteam, NULL, parent);
+        task->id.uid = first_uid + i;
+        task->child_number = first_child + i + 1;
+        tasks[i] = task;
+    }
+
+    // Siblings share wait counters and task groups
+    __sync_fetch_and_add(&(block[0].twc->count), num_tasks);
+    if (block[0].taskgroup)
+        __sync_fetch_and_add(&(block[0].taskgroup->count), num_tasks);
+
+    // Creation cost is shared equally
+    uint64_t creation_cycles = mir_get_cycles() - start_instant;
+    uint64_t create_instant = parent ? elapsed_execution_time(parent) : 0;
+    for (unsigned int i = 0; i < num_tasks; i++) {
+        block[i].creation_cycles = creation_cycles / num_tasks;
+        block[i].create_instant = create_instant;
+        T_DBG("Cr", &block[i]);
+    }
+} /*}}}*/
+
+// The function mir_task_create_batch() creates num_tasks sibling tasks
+// ... running tfunc. Argument block i starts at data + i * data_size.
+// The tasks are pushed to the scheduling policy in bulk.
+
+void mir_task_create_batch(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_tasks, const char* name)
+{ /*{{{*/
+    MIR_ASSERT(tfunc != NULL);
+
+    if (num_tasks == 0)
+        return;
+
+    // Non-worker threads, inlining and coarsening decide per task
+    if (mir_worker_try_get_context() == NULL || runtime->enable_task_coarsening == 1 || inline_necessary(tfunc) == 1) {
+        for (unsigned int i = 0; i < num_tasks; i++)
+            mir_task_create(tfunc, data_size > 0 ? (char*)data + i * data_size : data, data_size, 0, NULL, name);
+        return;
+    }
+
+    MIR_RECORDER_STATE_BEGIN(MIR_STATE_TCREATE);
+
+    // Overhead measurement
+    uint64_t start_instant = mir_get_cycles();
+
+    // Get this worker
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT(worker != NULL);
+    struct mir_task_t* parent = worker->current_task;
+
+    // Create tasks
+    struct mir_task_t** tasks = mir_malloc_int(num_tasks * sizeof(struct mir_task_t*));
+    MIR_CHECK_MEM(tasks != NULL);
+    mir_task_create_siblings(tfunc, data, data_size, data_size, num_tasks, name, NULL, tasks);
+
+    // Schedule tasks
+    mir_worker_schedule_many(worker, tasks, num_tasks);
+    mir_free_int(tasks, num_tasks * sizeof(struct mir_task_t*));
+
+    // Overhead measurement
+    if (parent)
+        parent->overhead_cycles += (mir_get_cycles() - start_instant);
+
+    MIR_RECORDER_STATE_END(NULL, 0);
+} /*}}}*/
+
+void mir_task_create_on_worker(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name, struct mir_omp_team_t* myteam, struct mir_loop_des_t* loopdes, int workerid)
+{ /*{{{*/
+    mir_task_create_on_worker_int(tfunc, data, data_size, num_data_footprints, data_footprints, name, myteam, loopdes, workerid, NULL, NULL);
+} /*}}}*/
+
+void mir_task_create_on_worker_attr(mir_tfunc_t tfunc, void* data, size_t data_size, const char* name, struct mir_omp_team_t* myteam, const struct mir_task_attr_t* attr)
+{ /*{{{*/
+    MIR_ASSERT(tfunc != NULL);
+
+    mir_task_create_on_worker_int(tfunc, data, data_size, 0, NULL, name, myteam, NULL, -1, attr, NULL);
+} /*}}}*/
+
+void mir_task_create_on_worker_depend_attr(mir_tfunc_t tfunc, void* data, size_t data_size, void** depend, const char* name, struct mir_omp_team_t* myteam, const struct mir_task_attr_t* attr)
+{ /*{{{*/
+    MIR_ASSERT(tfunc != NULL);
+
+    MIR_RECORDER_STATE_BEGIN(MIR_STATE_TCREATE);
+
+    // Get this worker
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT(worker != NULL);
+
+    // Create task
+    struct mir_task_t* task = mir_task_create_common(tfunc, data, data_size, 0, NULL, name, myteam, NULL, worker->current_task);
+    MIR_CHECK_MEM(task != NULL);
+    mir_task_apply_attr(task, attr);
+
+    // Hold task until sibling tasks it depends on are done
+    if (depend && mir_dep_register_depend(task, depend) == 0) {
+        T_DBG("Hd", task);
+        MIR_RECORDER_STATE_END(NULL, 0);
+        return;
+    }
+
+    // Schedule task
+    mir_task_schedule_on_worker(task, -1);
+
+    MIR_RECORDER_STATE_END(NULL, 0);
+} /*}}}*/
+
+void mir_task_create_on_worker_depend(mir_tfunc_t tfunc, void* data, size_t data_size, void** depend, const char* name, struct mir_omp_team_t* myteam)
+{ /*{{{*/
+    mir_task_create_on_worker_depend_attr(tfunc, data, data_size, depend, name, myteam, NULL);
+} /*}}}*/
+
+static inline struct mir_future_t* mir_future_create()
+{ /*{{{*/
+    struct mir_future_t* future = mir_malloc_int(sizeof(struct mir_future_t));
+    MIR_CHECK_MEM(future != NULL);
+    future->task = NULL;
+    future->done = 0;
+    future->value = NULL;
+
+    return future;
+} /*}}}*/
+
+struct mir_future_t* mir_task_create_future(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name)
+{ /*{{{*/
+    MIR_ASSERT(tfunc != NULL);
+    MIR_ASSERT_STR(mir_worker_try_get_context() != NULL, "Non-worker threads cannot create futures. Use mir_task_submit instead.");
+
+    struct mir_future_t* future = mir_future_create();
+
+    mir_task_create_on_worker_int(tfunc, data, data_size, num_data_footprints, data_footprints, name, NULL, NULL, -1, NULL, future);
+
+    return future;
+} /*}}}*/
+
+struct mir_future_t* mir_task_when_all(struct mir_future_t** preds, unsigned int num_preds, mir_tfunc_t tfunc, void* data, size_t data_size, const char* name)
+{ /*{{{*/
+    MIR_ASSERT(tfunc != NULL);
+    MIR_ASSERT(num_preds == 0 || preds != NULL);
+
+    // Get this worker
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    MIR_ASSERT_STR(worker != NULL, "Non-worker threads cannot create continuations.");
+
+    MIR_RECORDER_STATE_BEGIN(MIR_STATE_TCREATE);
+
+    struct mir_future_t* future = mir_future_create();
+
+    // Create task
+    struct mir_task_t* task = mir_task_create_common(tfunc, data, data_size, 0, NULL, name, NULL, NULL, worker->current_task);
+    MIR_CHECK_MEM(task != NULL);
+    task->future = future;
+    future->task = task;
+    task->dep = mir_dep_create();
+
+    // Wait for unfinished predecessors
+    // Their epilogs release this task
+    for (unsigned int i = 0; i < num_preds; i++) {
+        MIR_ASSERT(preds[i] != NULL);
+        if (preds[i]->done == 0 && preds[i]->task != NULL)
+            mir_dep_add_edge(preds[i]->task, task);
+    }
+
+    // Drop creator reference
+    if (__sync_sub_and_fetch(&task->dep->num_pending, 1) == 0)
+        mir_task_schedule_on_worker(task, -1);
+    else
+        T_DBG("Hd", task);
+
+    MIR_RECORDER_STATE_END(NULL, 0);
+
+    return future;
+} /*}}}*/
+
+struct mir_future_t* mir_task_then(struct mir_future_t* pred, mir_tfunc_t tfunc, void* data, size_t data_size, const char* name)
+{ /*{{{*/
+    MIR_ASSERT(pred != NULL);
+
+    return mir_task_when_all(&pred, 1, tfunc, data, data_size, name);
+} /*}}}*/
+
+int mir_future_done(struct mir_future_t* future)
+{ /*{{{*/
+    MIR_ASSERT(future != NULL);
+
+    return future->done == 1;
+} /*}}}*/
+
+static int mir_future_is_done(void* arg)
+{ /*{{{*/
+    return mir_future_done((struct mir_future_t*)arg);
+} /*}}}*/
+
+void* mir_future_get(struct mir_future_t* future)
+{ /*{{{*/
+    MIR_ASSERT(future != NULL);
+
+    if (future->done == 0) {
+        struct mir_worker_t* worker = mir_worker_try_get_context();
+        MIR_ASSERT_STR(worker != NULL, "Non-worker threads cannot wait on futures.");
+
+        MIR_RECORDER_STATE_BEGIN(MIR_STATE_TSYNC);
+
+        // Wait on this task only and do useful work
+        mir_task_wait_cond(worker, mir_future_is_done, future, NULL);
+
+        MIR_RECORDER_STATE_END(NULL, 0);
+    }
+
+    return future->value;
+} /*}}}*/
+
+void mir_future_destroy(struct mir_future_t* future)
+{ /*{{{*/
+    MIR_ASSERT(future != NULL);
+    MIR_ASSERT_STR(future->done == 1, "Cannot destroy future of a task that is not done.");
+
+    mir_free_int(future, sizeof(struct mir_future_t));
+} /*}}}*/
+
 static void mir_task_destroy(struct mir_task_t* task)
 { /*{{{*/
     // FIXME: Free the task!
@@ -333,6 +1016,10 @@ void mir_task_execute_prolog(struct mir_task_t* task)
     if (worker->current_task)
         worker->current_task->exec_cycles += (mir_get_cycles() - worker->current_task->exec_resume_instant);
 
+    // Let the waiting parent leapfrog to this worker
+    if (task->parent && task->parent != worker->current_task)
+        task->twc->thief = worker->id;
+
     // Save task context of worker
     task->predecessor = worker->current_task;
 
@@ -363,9 +1050,22 @@ void mir_task_execute_epilog(struct mir_task_t* task)
 
     //MIR_LOG_INFO("worker %d task %" MIR_FORMSPEC_UL " end", worker->id, task->id.uid);
 
+    // Schedule tiny children gathered so far
+    if (worker->bundle && worker->bundle->task->parent == task)
+        mir_task_bundle_flush(worker);
+
     // Record where executed
     task->cpu_id = worker->cpu_id;
 
+    // Record producer of written data
+    for (int i = 0; i < task->num_data_footprints; i++) {
+        if (task->data_footprints[i].data_access == MIR_DATA_ACCESS_WRITE) {
+            struct mir_task_producer_t* slot = mir_task_producer_slot(task->data_footprints[i].base);
+            slot->addr = task->data_footprints[i].base;
+            slot->worker = worker->id;
+        }
+    }
+
     // Current task timing
     task->exec_end_instant = mir_get_cycles() - runtime->init_time;
     task->exec_cycles += (mir_get_cycles() - task->exec_resume_instant);
@@ -399,12 +1099,27 @@ void mir_task_execute_epilog(struct mir_task_t* task)
     // Mark task as done
     task->done = 1;
 
+    // Publish the return value before continuations are released
+    if (task->future) {
+        __sync_synchronize();
+        task->future->done = 1;
+    }
+
+    // Release dependent tasks
+    if (task->dep)
+        mir_dep_release(worker, task);
+
     // Update task wait counter
     task->twc->count_per_worker[worker->id]++;
 
     // Signal
     T_DBG("Ex", task);
     __sync_synchronize();
+    if (task->handle)
+        mir_task_handle_signal(task->handle);
+
+    // Leave group last, it may be freed right after
+    mir_taskgroup_remove(task->taskgroup);
 
     // FIXME Destroy task !
     // NOTE: Destroying task upsets task list structure
@@ -414,13 +1129,31 @@ void mir_task_execute(struct mir_task_t* task)
 { /*{{{*/
     MIR_ASSERT(task != NULL);
 
+    // Measure runtime overhead for adaptive granularity control
+    int measure = mir_task_gran_enabled();
+    uint64_t prolog_start = 0, prolog_cycles = 0;
+    if (measure == 1)
+        prolog_start = mir_get_cycles();
+
     // Start profiling and book-keeping for task
     mir_task_execute_prolog(task);
 
+    if (measure == 1)
+        prolog_cycles = mir_get_cycles() - prolog_start;
+
     MIR_CONTEXT_EXIT;
 
     // Execute task function
-    task->func(task->data);
+    // Tasks of cancelled groups are dropped
+    if (mir_taskgroup_is_cancelled(task->taskgroup) == 0) {
+        void* value = task->func(task->data);
+        if (task->future)
+            task->future->value = value;
+    }
+    else if (task->func == (mir_tfunc_t)mir_task_bundle_execute) {
+        // Members are dropped with their bundle, which the bundle task frees
+        mir_free_int(*(struct mir_task_bundle_t**)task->data, sizeof(struct mir_task_bundle_t));
+    }
 
     MIR_CONTEXT_ENTER;
 
@@ -429,7 +1162,14 @@ void mir_task_execute(struct mir_task_t* task)
     // An example of chaining is the execution of loop chunks as tasks.
     struct mir_worker_t* worker = mir_worker_get_context();
     MIR_ASSERT(worker != NULL);
-    mir_task_execute_epilog(worker->current_task);
+    if (measure == 1 && task->func != (mir_tfunc_t)mir_task_bundle_execute) {
+        uint64_t epilog_start = mir_get_cycles();
+        mir_task_execute_epilog(worker->current_task);
+        mir_task_gran_sample(task, task->creation_cycles + prolog_cycles + (mir_get_cycles() - epilog_start));
+    }
+    else {
+        mir_task_execute_epilog(worker->current_task);
+    }
 
     // Debugging
     //MIR_LOG_INFO("Task %" MIR_FORMSPEC_UL " executed on worker %d\n", task->id.uid, worker->id);
@@ -491,6 +1231,42 @@ struct mir_mem_node_dist_t* mir_task_get_mem_node_dist(struct mir_task_t* task,
 } /*}}}*/
 #endif
 
+// The function mir_task_descends_from() checks if ancestor is up
+// ... the parent chain of task. Tasks are never freed so the walk is safe.
+
+int mir_task_descends_from(const struct mir_task_t* task, const struct mir_task_t* ancestor)
+{ /*{{{*/
+    for (const struct mir_task_t* t = task->parent; t != NULL; t = t->parent)
+        if (t == ancestor)
+            return 1;
+
+    return 0;
+} /*}}}*/
+
+// The function mir_task_wait_cond() does useful work until done(arg) holds.
+// Waits nest like task waits and count toward the depth limit.
+// Given the counter of the tasks waited for, the worker leapfrogs to
+// ... the worker that took one of them.
+
+void mir_task_wait_cond(struct mir_worker_t* worker, int (*done)(void*), void* arg, struct mir_twc_t* twc)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+
+    worker->wait_depth++;
+    while (done(arg) != 1) {
+        // With fibers the task steps aside until the wait is over
+        if (runtime->enable_fibers == 1) {
+            mir_fiber_suspend(worker, done, arg);
+            continue;
+        }
+
+        // __sync_synchronize();
+        // Sync with or without backoff
+        mir_worker_help(worker, twc, MIR_WORKER_BACKOFF_DURING_SYNC);
+    }
+    worker->wait_depth--;
+} /*}}}*/
+
 void mir_task_wait_int(struct mir_twc_t* twc, int newval)
 { /*{{{*/
     MIR_RECORDER_STATE_BEGIN(MIR_STATE_TSYNC);
@@ -507,11 +1283,7 @@ void mir_task_wait_int(struct mir_twc_t* twc, int newval)
     }
 
     // Wait and do useful work
-    while (mir_twc_reduce(twc) != 1) {
-        // __sync_synchronize();
-        // Sync with or without backoff
-        mir_worker_do_work(worker, MIR_WORKER_BACKOFF_DURING_SYNC);
-    }
+    mir_task_wait_cond(worker, mir_twc_done, twc, twc);
 
     // Record when passed and update num times passed
     // TODO: Should time update be locked?
@@ -526,9 +1298,20 @@ void mir_task_wait_int(struct mir_twc_t* twc, int newval)
 
     // Reset counts
     twc->count = newval;
+    twc->thief = -1;
     for (int i = 0; i < runtime->num_workers; i++)
         twc->count_per_worker[i] = 0;
 
+    // Children are done, forget their dependences
+    // Tasks created outside tasks share the domain of the runtime.
+    if (newval == 0) {
+        struct mir_task_t* task = worker->current_task;
+        if (task && task->ctwc == twc && task->dep_domain)
+            mir_dep_domain_reset(task->dep_domain);
+        else if (task == NULL && twc == runtime->ctwc)
+            mir_dep_domain_reset(runtime->dep_domain);
+    }
+
 exit:
     MIR_RECORDER_STATE_END(NULL, 0);
 
@@ -537,7 +1320,8 @@ exit:
 
 void mir_task_wait()
 { /*{{{*/
-    struct mir_worker_t* worker = pthread_getspecific(runtime->worker_index);
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    MIR_ASSERT_STR(worker != NULL, "Non-worker threads cannot call mir_task_wait. Wait on handles returned by mir_task_submit instead.");
     struct mir_twc_t* twc;
     if (worker->current_task)
         twc = worker->current_task->ctwc;
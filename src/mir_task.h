@@ -14,6 +14,8 @@
 #include "mir_loop.h"
 #include "mir_team.h"
 #include "mir_twc.h"
+#include "mir_dep.h"
+#include "mir_taskgroup.h"
 
 BEGIN_C_DECLS
 
@@ -69,6 +71,51 @@ BEGIN_C_DECLS
 // The task function pointer type
 /*PUB_INT*/ typedef void* (*mir_tfunc_t)(void*);
 
+/*PUB_INT_DECL_BEGIN*/
+struct mir_task_handle_t;
+struct mir_future_t;
+
+// Optional task creation attributes
+// Initialize with mir_task_attr_init() before setting fields.
+struct mir_task_attr_t {
+    int priority; // 0 is the lowest. Higher priorities are clamped to MIR_TASK_PRIORITY_LEVELS - 1.
+    // Soft affinity hints. The first one set is used.
+    int worker; // Preferred worker or -1
+    int node; // Preferred NUMA node or -1
+    void* near; // Prefer the node of the last task that wrote this address, or NULL
+};
+/*PUB_INT_DECL_END*/
+
+// Completion handle for tasks submitted by non-worker threads
+struct mir_task_handle_t { /*{{{*/
+    struct mir_task_t* task;
+    volatile uint32_t done;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+}; /*}}}*/
+
+// Return value of a task, for joining on single tasks
+struct mir_future_t { /*{{{*/
+    struct mir_task_t* task; // NULL if inlined
+    volatile uint32_t done;
+    void* value;
+}; /*}}}*/
+
+// Tiny sibling tasks executed serially as one task
+struct mir_task_bundle_entry_t { /*{{{*/
+    mir_tfunc_t func;
+    uint32_t data_offset;
+}; /*}}}*/
+
+struct mir_task_bundle_t { /*{{{*/
+    struct mir_task_t* task; // Runs the bundle
+    uint32_t num_tasks;
+    uint32_t target_size; // Adapted to measured task cost
+    uint32_t data_used;
+    struct mir_task_bundle_entry_t entries[MIR_TASK_BUNDLE_MAX_SIZE];
+    char data[MIR_TASK_BUNDLE_DATA_SIZE];
+}; /*}}}*/
+
 // The task
 struct mir_task_t { /*{{{*/
     mir_tfunc_t func;
@@ -98,11 +145,33 @@ struct mir_task_t { /*{{{*/
     uint32_t queue_size_at_pop;
     struct mir_loop_des_t* loop;
     struct mir_omp_team_t* team;
+    // Data of numa loops started by this task and its children
+    void* loop_base;
+    size_t loop_stride;
+
+    // Scheduling attributes
+    int priority;
+    int affinity_worker; // -1 if none
+    int affinity_node; // -1 if none
 
     // Flags
     uint32_t done;
     uint32_t taken;
 
+    // Signalled when done. Set for tasks submitted by non-worker threads.
+    struct mir_task_handle_t* handle;
+
+    // Receives the return value. Set for tasks created with mir_task_create_future.
+    struct mir_future_t* future;
+
+    // Task groups
+    struct mir_taskgroup_t* taskgroup; // Group this task belongs to
+    struct mir_taskgroup_t* child_taskgroup; // Innermost group open in this task
+
+    // Data dependences
+    struct mir_dep_t* dep;
+    struct mir_dep_domain_t* dep_domain; // For children
+
     // Data footprint
     struct mir_data_footprint_t* data_footprints;
     uint32_t num_data_footprints;
@@ -122,15 +191,64 @@ static void T_DBG(char* msg, struct mir_task_t* t)
 
 /*PUB_INT*/ void mir_task_create(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name);
 
+/*PUB_INT*/ void mir_task_create_batch(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_tasks, const char* name);
+
+/*PUB_INT*/ void mir_task_attr_init(struct mir_task_attr_t* attr);
+
+/*PUB_INT*/ void mir_task_create_attr(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name, const struct mir_task_attr_t* attr);
+
+/*PUB_INT*/ struct mir_task_handle_t* mir_task_submit(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name);
+
+/*PUB_INT*/ int mir_task_handle_test(struct mir_task_handle_t* handle);
+
+/*PUB_INT*/ void mir_task_handle_wait(struct mir_task_handle_t* handle);
+
+/*PUB_INT*/ void mir_task_handle_destroy(struct mir_task_handle_t* handle);
+
+/*PUB_INT*/ struct mir_future_t* mir_task_create_future(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name);
+
+// Continuations run once their predecessors are done
+// Predecessor values are read through the futures.
+/*PUB_INT*/ struct mir_future_t* mir_task_then(struct mir_future_t* pred, mir_tfunc_t tfunc, void* data, size_t data_size, const char* name);
+
+/*PUB_INT*/ struct mir_future_t* mir_task_when_all(struct mir_future_t** preds, unsigned int num_preds, mir_tfunc_t tfunc, void* data, size_t data_size, const char* name);
+
+/*PUB_INT*/ int mir_future_done(struct mir_future_t* future);
+
+/*PUB_INT*/ void* mir_future_get(struct mir_future_t* future);
+
+/*PUB_INT*/ void mir_future_destroy(struct mir_future_t* future);
+
 struct mir_task_t* mir_task_create_twin(char *name, struct mir_task_t* task, char *str);
 
 struct mir_task_t* mir_task_create_common(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, const struct mir_data_footprint_t* data_footprints, const char* name, struct mir_omp_team_t* myteam, struct mir_loop_des_t* loopdes, struct mir_task_t* parent);
 
+// Creates a child of the current task counted by the given wait counter
+void mir_task_create_counted(mir_tfunc_t tfunc, void* data, size_t data_size, const char* name, struct mir_twc_t* twc, const struct mir_task_attr_t* attr);
+
+// Creates children of the current task without scheduling them
+void mir_task_create_siblings(mir_tfunc_t tfunc, void* data, size_t data_size, size_t data_stride, unsigned int num_tasks, const char* name, struct mir_omp_team_t* myteam, struct mir_task_t** tasks);
+
 void mir_task_create_on_worker(mir_tfunc_t tfunc, void* data, size_t data_size, unsigned int num_data_footprints, struct mir_data_footprint_t* data_footprints, const char* name, struct mir_omp_team_t* myteam, struct mir_loop_des_t* loopdes, int workerid);
 
+// For OpenMP tasks with depend clauses. The depend array is in libgomp layout.
+void mir_task_create_on_worker_depend(mir_tfunc_t tfunc, void* data, size_t data_size, void** depend, const char* name, struct mir_omp_team_t* myteam);
+
+// For OpenMP tasks with depend clauses and attributes such as priority
+void mir_task_create_on_worker_depend_attr(mir_tfunc_t tfunc, void* data, size_t data_size, void** depend, const char* name, struct mir_omp_team_t* myteam, const struct mir_task_attr_t* attr);
+
+// For OpenMP tasks with attributes such as priority
+void mir_task_create_on_worker_attr(mir_tfunc_t tfunc, void* data, size_t data_size, const char* name, struct mir_omp_team_t* myteam, const struct mir_task_attr_t* attr);
+
+// Sets attributes of a task that is not scheduled yet
+void mir_task_apply_attr(struct mir_task_t* task, const struct mir_task_attr_t* attr);
+
 // TODO: Differentiate with mir_task_create_on_worker().
 void mir_task_schedule_on_worker(struct mir_task_t* task, int workerid);
 
+// Schedules the open bundle of the worker
+void mir_task_bundle_flush(struct mir_worker_t* worker);
+
 void mir_task_execute_prolog(struct mir_task_t* task);
 
 void mir_task_execute_epilog(struct mir_task_t* task);
@@ -143,6 +261,12 @@ void mir_task_write_metadata(struct mir_task_t* task, const char* metadata);
 struct mir_mem_node_dist_t* mir_task_get_mem_node_dist(struct mir_task_t* task, mir_data_access_t access);
 #endif
 
+int mir_task_producer_of(const void* addr);
+
+int mir_task_descends_from(const struct mir_task_t* task, const struct mir_task_t* ancestor);
+
+void mir_task_wait_cond(struct mir_worker_t* worker, int (*done)(void*), void* arg, struct mir_twc_t* twc);
+
 void mir_task_wait_int(struct mir_twc_t* twc, int newval);
 
 /*PUB_INT*/ void mir_task_wait();
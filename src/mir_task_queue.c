@@ -63,6 +63,30 @@ int mir_task_queue_push(struct mir_task_queue_t* queue, struct mir_task_t* data)
     return 1;
 } /*}}}*/
 
+uint32_t mir_task_queue_push_many(struct mir_task_queue_t* queue, struct mir_task_t** tasks, uint32_t num_tasks)
+{ /*{{{*/
+    MIR_ASSERT(queue != NULL);
+    MIR_ASSERT(tasks != NULL);
+
+    mir_lock_set(&(queue->enq_lock));
+
+    // Add as many as fit
+    uint32_t room = queue->capacity - queue->size;
+    uint32_t num_pushed = num_tasks < room ? num_tasks : room;
+    for (uint32_t i = 0; i < num_pushed; i++) {
+        MIR_ASSERT(tasks[i] != NULL);
+        queue->buffer[queue->in] = tasks[i];
+        queue->in++;
+        if (queue->in >= queue->capacity)
+            queue->in -= queue->capacity;
+    }
+    __sync_fetch_and_add(&(queue->size), num_pushed);
+
+    mir_lock_unset(&(queue->enq_lock));
+
+    return num_pushed;
+} /*}}}*/
+
 struct mir_task_t* mir_task_queue_pop(struct mir_task_queue_t* queue)
 { /*{{{*/
     MIR_ASSERT(queue != NULL);
@@ -75,22 +99,37 @@ struct mir_task_t* mir_task_queue_pop(struct mir_task_queue_t* queue)
     }
     task = queue->buffer[queue->out];
     MIR_ASSERT(task != NULL);
-#ifdef MIR_GPL
-    struct mir_worker_t* worker = mir_worker_get_context();
-    if (!runtime->single_parallel_block && task->team) {
-        // The private queue is FIFO ordered. We have either already
-        // executed the parallel block or will execute it right now.
-        //
-        // If we are stealing from another queue, ensure we have executed
-        // our parallel block first.
-        if ((void *)queue == worker->private_queue)
-            task->team->parallel_block_flag[worker->id] = 1;
-        else if (task->team->parallel_block_flag[worker->id] == 0) {
-            task = NULL;
-            goto cleanup;
-	}
+
+    __sync_fetch_and_sub(&(queue->size), 1);
+    queue->out++;
+    if (queue->out >= queue->capacity)
+        queue->out -= queue->capacity;
+
+cleanup:
+    mir_lock_unset(&(queue->deq_lock));
+
+    return task;
+} /*}}}*/
+
+struct mir_task_t* mir_task_queue_pop_descendant(struct mir_task_queue_t* queue, const struct mir_task_t* ancestor)
+{ /*{{{*/
+    MIR_ASSERT(queue != NULL);
+    MIR_ASSERT(ancestor != NULL);
+    struct mir_task_t* task = NULL;
+
+    mir_lock_set(&(queue->deq_lock));
+    if (TASK_QUEUE_EMPTY(queue)) {
+        TQ_DBG("queue empty!", queue);
+        goto cleanup;
+    }
+    task = queue->buffer[queue->out];
+    MIR_ASSERT(task != NULL);
+
+    // Leave other tasks in place
+    if (0 == mir_task_descends_from(task, ancestor)) {
+        task = NULL;
+        goto cleanup;
     }
-#endif
 
     __sync_fetch_and_sub(&(queue->size), 1);
     queue->out++;
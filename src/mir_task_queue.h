@@ -45,9 +45,15 @@ void mir_task_queue_destroy(struct mir_task_queue_t* queue);
 // Add an element to the task queue.
 int mir_task_queue_push(struct mir_task_queue_t* queue, struct mir_task_t* task);
 
+// Add several elements to the task queue. Returns the number added.
+uint32_t mir_task_queue_push_many(struct mir_task_queue_t* queue, struct mir_task_t** tasks, uint32_t num_tasks);
+
 // Remove an element from the task queue.
 struct mir_task_t* mir_task_queue_pop(struct mir_task_queue_t* queue);
 
+// Remove the element at the head of the task queue if it descends from ancestor.
+struct mir_task_t* mir_task_queue_pop_descendant(struct mir_task_queue_t* queue, const struct mir_task_t* ancestor);
+
 // Get task queue size
 uint32_t mir_task_queue_size(const struct mir_task_queue_t* queue);
 
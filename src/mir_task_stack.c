@@ -54,6 +54,27 @@ int mir_task_stack_push(struct mir_task_stack_t* stack, struct mir_task_t* data)
     return 1;
 } /*}}}*/
 
+uint32_t mir_task_stack_push_many(struct mir_task_stack_t* stack, struct mir_task_t** data, uint32_t num_data)
+{ /*{{{*/
+    MIR_ASSERT(stack != NULL);
+    MIR_ASSERT(data != NULL);
+
+    mir_lock_set(&(stack->lock));
+
+    // Add as many as fit
+    uint32_t room = stack->capacity - stack->head;
+    uint32_t num_pushed = num_data < room ? num_data : room;
+    for (uint32_t i = 0; i < num_pushed; i++) {
+        MIR_ASSERT(data[i] != NULL);
+        stack->buffer[stack->head + i] = (void*)data[i];
+    }
+    stack->head += num_pushed;
+
+    mir_lock_unset(&(stack->lock));
+
+    return num_pushed;
+} /*}}}*/
+
 void mir_task_stack_pop(struct mir_task_stack_t* stack, struct mir_task_t** data)
 { /*{{{*/
     MIR_ASSERT(stack != NULL);
@@ -65,17 +86,33 @@ void mir_task_stack_pop(struct mir_task_stack_t* stack, struct mir_task_t** data
         goto cleanup;
     }
 
-#ifdef MIR_GPL
-    // Ensure we have executed our parallel block before this task.
+    *data = stack->buffer[stack->head - 1];
+    MIR_ASSERT(*data != NULL);
+    stack->head--;
+
+cleanup:
+    mir_lock_unset(&(stack->lock));
+} /*}}}*/
+
+void mir_task_stack_pop_descendant(struct mir_task_stack_t* stack, const struct mir_task_t* ancestor, struct mir_task_t** data)
+{ /*{{{*/
+    MIR_ASSERT(stack != NULL);
+    MIR_ASSERT(ancestor != NULL);
+    MIR_ASSERT(data != NULL);
+
+    mir_lock_set(&(stack->lock));
+    if (TASK_STACK_EMPTY(stack)) {
+        TS_DBG("stack empty", stack);
+        goto cleanup;
+    }
+
+    // Leave other tasks in place
     struct mir_task_t* task = stack->buffer[stack->head - 1];
-    struct mir_worker_t* worker = mir_worker_get_context();
-    if (!runtime->single_parallel_block && task->team &&
-        task->team->parallel_block_flag[worker->id] == 0)
+    MIR_ASSERT(task != NULL);
+    if (0 == mir_task_descends_from(task, ancestor))
         goto cleanup;
-#endif
 
-    *data = stack->buffer[stack->head - 1];
-    MIR_ASSERT(*data != NULL);
+    *data = task;
     stack->head--;
 
 cleanup:
@@ -42,9 +42,15 @@ void mir_task_stack_destroy(struct mir_task_stack_t* stack);
 // Add an element to the task stack.
 int mir_task_stack_push(struct mir_task_stack_t* stack, struct mir_task_t* data);
 
+// Add several elements to the task stack. Returns the number added.
+uint32_t mir_task_stack_push_many(struct mir_task_stack_t* stack, struct mir_task_t** data, uint32_t num_data);
+
 // Remove an element from the task stack.
 void mir_task_stack_pop(struct mir_task_stack_t* stack, struct mir_task_t** data);
 
+// Remove the element on top of the task stack if it descends from ancestor.
+void mir_task_stack_pop_descendant(struct mir_task_stack_t* stack, const struct mir_task_t* ancestor, struct mir_task_t** data);
+
 // Get the current task stack size.
 uint32_t mir_task_stack_size(const struct mir_task_stack_t* stack);
 
@@ -0,0 +1,141 @@
+#include "mir_taskgroup.h"
+#include "mir_task.h"
+#include "mir_worker.h"
+#include "mir_runtime.h"
+#include "mir_memory.h"
+#include "mir_utils.h"
+#include "mir_defines.h"
+#include "mir_recorder.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// The function mir_taskgroup_current() returns the innermost group open
+// ... in the calling context. Tasks created now become its members.
+
+struct mir_taskgroup_t* mir_taskgroup_current()
+{ /*{{{*/
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    if (worker == NULL)
+        return NULL;
+
+    if (worker->current_task)
+        return worker->current_task->child_taskgroup;
+
+    return runtime->taskgroup;
+} /*}}}*/
+
+static inline void mir_taskgroup_set_current(struct mir_taskgroup_t* group)
+{ /*{{{*/
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT(worker != NULL);
+
+    if (worker->current_task)
+        worker->current_task->child_taskgroup = group;
+    else
+        runtime->taskgroup = group;
+} /*}}}*/
+
+void mir_taskgroup_start()
+{ /*{{{*/
+    struct mir_taskgroup_t* group = mir_malloc_int(sizeof(struct mir_taskgroup_t));
+    MIR_CHECK_MEM(group != NULL);
+
+    group->parent = mir_taskgroup_current();
+    group->cancelled = 0;
+    group->count = 0;
+
+    mir_taskgroup_set_current(group);
+} /*}}}*/
+
+static int mir_taskgroup_done(void* arg)
+{ /*{{{*/
+    return ((struct mir_taskgroup_t*)arg)->count == 0;
+} /*}}}*/
+
+void mir_taskgroup_end()
+{ /*{{{*/
+    struct mir_taskgroup_t* group = mir_taskgroup_current();
+    MIR_ASSERT_STR(group != NULL, "No taskgroup to end.");
+
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT(worker != NULL);
+
+    MIR_RECORDER_STATE_BEGIN(MIR_STATE_TSYNC);
+
+    // Wait for members and their descendants in one go
+    // Members are counted before their creator finishes,
+    // ... so the count reaches zero only once.
+    mir_task_wait_cond(worker, mir_taskgroup_done, group, NULL);
+
+    MIR_RECORDER_STATE_END(NULL, 0);
+
+    mir_taskgroup_set_current(group->parent);
+
+    // Finished members no longer refer to the group
+    mir_free_int(group, sizeof(struct mir_taskgroup_t));
+} /*}}}*/
+
+// The function mir_taskgroup_cancel() cancels the group the calling task
+// ... belongs to, along with groups nested in it. Groups the task has
+// ... opened itself are not its own. Outside tasks, the innermost open
+// ... group is cancelled.
+
+void mir_taskgroup_cancel()
+{ /*{{{*/
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    if (worker == NULL)
+        return;
+
+    struct mir_taskgroup_t* group;
+    if (worker->current_task)
+        group = worker->current_task->taskgroup;
+    else
+        group = runtime->taskgroup;
+
+    if (group) {
+        group->cancelled = 1;
+        __sync_synchronize();
+    }
+} /*}}}*/
+
+int mir_task_cancelled()
+{ /*{{{*/
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+    if (worker == NULL || worker->current_task == NULL)
+        return 0;
+
+    return mir_taskgroup_is_cancelled(worker->current_task->taskgroup);
+} /*}}}*/
+
+#ifdef MIR_GPL
+void GOMP_taskgroup_start(void)
+{ /*{{{*/
+    mir_taskgroup_start();
+} /*}}}*/
+
+void GOMP_taskgroup_end(void)
+{ /*{{{*/
+    mir_taskgroup_end();
+} /*}}}*/
+
+bool GOMP_cancel(int which, bool do_cancel)
+{ /*{{{*/
+    // Only taskgroup cancellation is supported
+    if (which != GOMP_CANCEL_TASKGROUP)
+        return false;
+
+    if (do_cancel)
+        mir_taskgroup_cancel();
+
+    return mir_task_cancelled() == 1;
+} /*}}}*/
+
+bool GOMP_cancellation_point(int which)
+{ /*{{{*/
+    if (which != GOMP_CANCEL_TASKGROUP)
+        return false;
+
+    return mir_task_cancelled() == 1;
+} /*}}}*/
+#endif
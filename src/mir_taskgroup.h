@@ -0,0 +1,54 @@
+#ifndef MIR_TASKGROUP_H
+#define MIR_TASKGROUP_H 1
+
+#include <stdint.h>
+
+#include "mir_types.h"
+
+BEGIN_C_DECLS
+
+struct mir_task_t;
+
+// A group of tasks that can be cancelled and waited for together
+// Tasks belong to the innermost group open in their creator.
+// Members create members, so the group covers all descendants.
+struct mir_taskgroup_t { /*{{{*/
+    struct mir_taskgroup_t* parent; // Enclosing group
+    volatile uint32_t cancelled;
+    volatile uint32_t count; // Unfinished members
+}; /*}}}*/
+
+static inline int mir_taskgroup_is_cancelled(const struct mir_taskgroup_t* group)
+{ /*{{{*/
+    // Cancelling a group cancels groups nested in it
+    for (; group; group = group->parent)
+        if (group->cancelled == 1)
+            return 1;
+
+    return 0;
+} /*}}}*/
+
+static inline void mir_taskgroup_add(struct mir_taskgroup_t* group)
+{ /*{{{*/
+    if (group)
+        __sync_fetch_and_add(&(group->count), 1);
+} /*}}}*/
+
+static inline void mir_taskgroup_remove(struct mir_taskgroup_t* group)
+{ /*{{{*/
+    if (group)
+        __sync_fetch_and_sub(&(group->count), 1);
+} /*}}}*/
+
+struct mir_taskgroup_t* mir_taskgroup_current();
+
+/*PUB_INT*/ void mir_taskgroup_start();
+
+/*PUB_INT*/ void mir_taskgroup_end();
+
+/*PUB_INT*/ void mir_taskgroup_cancel();
+
+/*PUB_INT*/ int mir_task_cancelled();
+
+END_C_DECLS
+#endif
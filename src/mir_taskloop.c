@@ -0,0 +1,268 @@
+#include "mir_taskloop.h"
+#include "mir_task.h"
+#include "mir_taskgroup.h"
+#include "mir_twc.h"
+#include "mir_worker.h"
+#include "mir_runtime.h"
+#include "mir_utils.h"
+#include "mir_defines.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alloca.h>
+
+extern uint32_t g_num_tasks_waiting;
+
+typedef struct mir_taskloop_range_t { /*{{{*/
+    struct mir_taskloop_des_t* loop;
+    long start;
+    long end;
+} mir_taskloop_range_t; /*}}}*/
+
+static void mir_taskloop_run(struct mir_taskloop_des_t* loop, long start, long end);
+
+static void* mir_taskloop_task(void* arg)
+{ /*{{{*/
+    mir_taskloop_range_t* range = (mir_taskloop_range_t*)arg;
+    mir_taskloop_run(range->loop, range->start, range->end);
+
+    return NULL;
+} /*}}}*/
+
+static inline int mir_taskloop_split_wanted()
+{ /*{{{*/
+    // Split only while there are fewer waiting tasks than workers
+    return g_num_tasks_waiting < runtime->num_workers;
+} /*}}}*/
+
+// Lazy binary splitting
+// The upper half of the range is offered as a task only when workers are hungry.
+// The caller keeps the lower half and executes it one grain at a time.
+static void mir_taskloop_run(struct mir_taskloop_des_t* loop, long start, long end)
+{ /*{{{*/
+    MIR_ASSERT(loop != NULL);
+
+    // The descriptor can disappear once the last range task is done
+    mir_taskloop_func_t func = loop->func;
+    void* data = loop->data;
+    long grainsize = loop->grainsize;
+
+    while (start < end) {
+        if (end - start > grainsize && mir_taskloop_split_wanted()) {
+            long mid = start + (end - start) / 2;
+            mir_taskloop_range_t range;
+            range.loop = loop;
+            range.start = mid;
+            range.end = end;
+            mir_task_create_counted((mir_tfunc_t)mir_taskloop_task, (void*)&range, sizeof(mir_taskloop_range_t), "taskloop", loop->twc, loop->attr);
+            end = mid;
+            continue;
+        }
+
+        // Iterations of cancelled groups are dropped
+        if (mir_taskgroup_is_cancelled(mir_taskgroup_current()) == 1)
+            break;
+
+        long chunk_end = (end - start > grainsize) ? start + grainsize : end;
+        func(start, chunk_end, data);
+        start = chunk_end;
+    }
+} /*}}}*/
+
+static void mir_taskloop_int(mir_taskloop_func_t func, void* data, long start, long end, long grainsize, long num_tasks, const struct mir_task_attr_t* attr)
+{ /*{{{*/
+    MIR_ASSERT(func != NULL);
+
+    if (end <= start)
+        return;
+
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT_STR(worker != NULL, "Taskloops can be started only by workers.");
+
+    // Grain size precedes number of tasks
+    long num_iters = end - start;
+    if (grainsize <= 0) {
+        if (num_tasks <= 0)
+            num_tasks = runtime->num_workers * MIR_TASKLOOP_TASKS_PER_WORKER;
+        grainsize = (num_iters + num_tasks - 1) / num_tasks;
+    }
+    if (grainsize <= 0)
+        grainsize = 1;
+
+    struct mir_taskloop_des_t loop;
+    loop.func = func;
+    loop.data = data;
+    loop.grainsize = grainsize;
+    loop.twc = mir_twc_create();
+    loop.attr = attr;
+
+    mir_taskloop_run(&loop, start, end);
+
+    // Wait for range tasks like for children
+    // Range tasks dropped by cancellation are counted as done.
+    mir_task_wait_int(loop.twc, 0);
+    mir_twc_destroy(loop.twc);
+} /*}}}*/
+
+void mir_taskloop(mir_taskloop_func_t func, void* data, long start, long end, long grainsize, long num_tasks)
+{ /*{{{*/
+    mir_taskloop_int(func, data, start, end, grainsize, num_tasks, NULL);
+} /*}}}*/
+
+#ifdef MIR_GPL
+typedef struct mir_omp_taskloop_t { /*{{{*/
+    void (*fn)(void*);
+    void* data;
+    void (*cpyfn)(void*, void*);
+    long arg_size;
+    long arg_align;
+    long start;
+    long step;
+} mir_omp_taskloop_t; /*}}}*/
+
+// The function mir_omp_taskloop_fill() sets up the argument block of a chunk.
+// Each chunk gets its own copy of firstprivate data.
+
+static inline void mir_omp_taskloop_fill(const mir_omp_taskloop_t* tl, char* arg_buf, long start, long end)
+{ /*{{{*/
+    if (tl->cpyfn)
+        tl->cpyfn(arg_buf, tl->data);
+    else
+        memcpy(arg_buf, tl->data, tl->arg_size);
+
+    // Outlined taskloop functions read their bounds from the head of the data
+    ((long*)arg_buf)[0] = tl->start + start * tl->step;
+    ((long*)arg_buf)[1] = tl->start + end * tl->step;
+} /*}}}*/
+
+static void mir_omp_taskloop_body(long start, long end, void* arg)
+{ /*{{{*/
+    mir_omp_taskloop_t* tl = (mir_omp_taskloop_t*)arg;
+
+    char* buf = alloca(tl->arg_size + tl->arg_align - 1);
+    char* arg_buf = (char*)(((uintptr_t)buf + tl->arg_align - 1) & ~(uintptr_t)(tl->arg_align - 1));
+    mir_omp_taskloop_fill(tl, arg_buf, start, end);
+
+    tl->fn(arg_buf);
+} /*}}}*/
+
+// Task data of a chunk created up front
+// The argument block follows, aligned as the compiler asks.
+typedef struct mir_omp_taskloop_chunk_t { /*{{{*/
+    void (*fn)(void*);
+    long arg_align;
+} mir_omp_taskloop_chunk_t; /*}}}*/
+
+static inline char* mir_omp_taskloop_chunk_arg(mir_omp_taskloop_chunk_t* chunk)
+{ /*{{{*/
+    uintptr_t buf = (uintptr_t)(chunk + 1);
+    return (char*)((buf + chunk->arg_align - 1) & ~(uintptr_t)(chunk->arg_align - 1));
+} /*}}}*/
+
+static void* mir_omp_taskloop_chunk(void* arg)
+{ /*{{{*/
+    mir_omp_taskloop_chunk_t* chunk = (mir_omp_taskloop_chunk_t*)arg;
+    chunk->fn(mir_omp_taskloop_chunk_arg(chunk));
+
+    return NULL;
+} /*}}}*/
+
+// The function mir_omp_taskloop_nogroup() creates all chunks up front.
+// Without a taskgroup the construct does not wait, so the data of the
+// ... encountering task may be gone before chunks run. Chunks copy their
+// ... firstprivate data when created, into their own task data.
+// Returns 0 if the data does not fit in task data.
+
+static int mir_omp_taskloop_nogroup(const mir_omp_taskloop_t* tl, long num_iters, long grainsize, long num_tasks, const struct mir_task_attr_t* attr)
+{ /*{{{*/
+    size_t data_size = sizeof(mir_omp_taskloop_chunk_t) + tl->arg_size + tl->arg_align - 1;
+    if (data_size > MIR_TASK_DATA_MAX_SIZE)
+        return 0;
+
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT_STR(worker != NULL, "Taskloops can be started only by workers.");
+
+    // Grain size precedes number of tasks
+    if (grainsize <= 0) {
+        if (num_tasks <= 0)
+            num_tasks = runtime->num_workers * MIR_TASKLOOP_TASKS_PER_WORKER;
+        grainsize = (num_iters + num_tasks - 1) / num_tasks;
+    }
+    if (grainsize <= 0)
+        grainsize = 1;
+
+    char* zeros = alloca(data_size);
+    memset(zeros, 0, data_size);
+
+    for (long start = 0; start < num_iters; start += grainsize) {
+        long end = (num_iters - start > grainsize) ? start + grainsize : num_iters;
+
+        struct mir_task_t* task = mir_task_create_common((mir_tfunc_t)mir_omp_taskloop_chunk, zeros, data_size, 0, NULL, "taskloop", NULL, NULL, worker->current_task);
+        MIR_CHECK_MEM(task != NULL);
+        mir_task_apply_attr(task, attr);
+
+        // Task data does not move once created
+        mir_omp_taskloop_chunk_t* chunk = (mir_omp_taskloop_chunk_t*)task->data;
+        chunk->fn = tl->fn;
+        chunk->arg_align = tl->arg_align;
+        mir_omp_taskloop_fill(tl, mir_omp_taskloop_chunk_arg(chunk), start, end);
+
+        mir_task_schedule_on_worker(task, -1);
+    }
+
+    return 1;
+} /*}}}*/
+
+void GOMP_taskloop(void (*fn)(void*), void* data, void (*cpyfn)(void*, void*), long arg_size, long arg_align, unsigned flags, unsigned long num_tasks, int priority, long start, long end, long step)
+{ /*{{{*/
+    MIR_ASSERT(step != 0);
+
+    // Iteration count
+    long num_iters;
+    if (step > 0)
+        num_iters = start < end ? (end - start + step - 1) / step : 0;
+    else
+        num_iters = start > end ? (start - end - step - 1) / -step : 0;
+    if (num_iters == 0)
+        return;
+
+    mir_omp_taskloop_t tl;
+    tl.fn = fn;
+    tl.data = data;
+    tl.cpyfn = cpyfn;
+    tl.arg_size = arg_size;
+    tl.arg_align = arg_align > 0 ? arg_align : 1;
+    tl.start = start;
+    tl.step = step;
+
+    long grainsize = 0;
+    long ntasks = 0;
+    if ((flags & GOMP_TASK_FLAG_IF) == 0)
+        grainsize = num_iters;
+    else if (flags & GOMP_TASK_FLAG_GRAINSIZE)
+        grainsize = (long)num_tasks;
+    else
+        ntasks = (long)num_tasks;
+
+    struct mir_task_attr_t attr;
+    mir_task_attr_init(&attr);
+    attr.priority = priority > 0 ? priority : 0;
+
+    // Undeferred loops run in one range at once
+    // Chunks with too much data to copy run in place, waiting like a group.
+    int group = (flags & GOMP_TASK_FLAG_NOGROUP) == 0;
+    if (group == 0 && (flags & GOMP_TASK_FLAG_IF)) {
+        if (1 == mir_omp_taskloop_nogroup(&tl, num_iters, grainsize, ntasks, &attr))
+            return;
+    }
+
+    // The construct is an implicit taskgroup
+    // Tasks created by iterations are waited for as well.
+    if (group)
+        mir_taskgroup_start();
+    mir_taskloop_int(mir_omp_taskloop_body, &tl, 0, num_iters, grainsize, ntasks, &attr);
+    if (group)
+        mir_taskgroup_end();
+} /*}}}*/
+#endif
@@ -0,0 +1,28 @@
+#ifndef MIR_TASKLOOP_H
+#define MIR_TASKLOOP_H 1
+
+#include <stdint.h>
+
+#include "mir_types.h"
+
+BEGIN_C_DECLS
+
+struct mir_twc_t;
+struct mir_task_attr_t;
+
+// The taskloop body executes iterations [start, end)
+/*PUB_INT*/ typedef void (*mir_taskloop_func_t)(long, long, void*);
+
+// A running taskloop
+struct mir_taskloop_des_t { /*{{{*/
+    mir_taskloop_func_t func;
+    void* data;
+    long grainsize;
+    struct mir_twc_t* twc; // Counts range tasks split off
+    const struct mir_task_attr_t* attr; // Attributes of range tasks, NULL for none
+}; /*}}}*/
+
+/*PUB_INT*/ void mir_taskloop(mir_taskloop_func_t func, void* data, long start, long end, long grainsize, long num_tasks);
+
+END_C_DECLS
+#endif
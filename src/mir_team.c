@@ -1,20 +1,261 @@
 #include "mir_memory.h"
+#include "mir_runtime.h"
+#include "mir_task.h"
 #include "mir_team.h"
 #include "mir_utils.h"
+#include "mir_worker.h"
+
+#include <string.h>
+
+// Teams not in use
+static struct mir_omp_team_t* g_omp_team_pool = NULL;
+static struct mir_lock_t g_omp_team_pool_lock;
+
+// Teams whose workers watch the generation word
+static struct mir_omp_team_t* volatile g_omp_teams_started = NULL;
+static struct mir_lock_t g_omp_teams_started_lock;
+static volatile uint32_t g_num_omp_teams_started = 0;
+
+// Team tasks taken by workers that have not executed their parallel block
+static struct mir_task_list_t* g_omp_team_tasks_deferred = NULL;
+static struct mir_lock_t g_omp_team_tasks_deferred_lock;
+static volatile uint32_t g_num_omp_team_tasks_deferred = 0;
+
+void mir_omp_team_pool_create()
+{ /*{{{*/
+    g_omp_team_pool = NULL;
+    g_omp_teams_started = NULL;
+    g_num_omp_teams_started = 0;
+    g_omp_team_tasks_deferred = NULL;
+    g_num_omp_team_tasks_deferred = 0;
+    mir_lock_create(&g_omp_team_pool_lock);
+    mir_lock_create(&g_omp_teams_started_lock);
+    mir_lock_create(&g_omp_team_tasks_deferred_lock);
+} /*}}}*/
+
+void mir_omp_team_pool_destroy()
+{ /*{{{*/
+    MIR_ASSERT(g_omp_team_tasks_deferred == NULL);
+
+    while (g_omp_team_pool) {
+        struct mir_omp_team_t* team = g_omp_team_pool;
+        g_omp_team_pool = team->next;
+        mir_barrier_destroy(&team->barrier);
+        mir_lock_destroy(&team->loop_lock);
+        mir_free_int(team, sizeof(struct mir_omp_team_t));
+    }
+
+    mir_lock_destroy(&g_omp_team_pool_lock);
+    mir_lock_destroy(&g_omp_teams_started_lock);
+    mir_lock_destroy(&g_omp_team_tasks_deferred_lock);
+} /*}}}*/
+
+// The function mir_new_omp_team() takes a team from the pool if possible.
+// Pooled teams keep their lock and barrier, the barrier is rebuilt
+// ... only when the team size changes.
 
 struct mir_omp_team_t* mir_new_omp_team(struct mir_omp_team_t* pteam, unsigned nthreads)
 { /*{{{*/
-    struct mir_omp_team_t* team = mir_malloc_int(sizeof(struct mir_omp_team_t));
-    MIR_CHECK_MEM(team != NULL);
+    mir_lock_set(&g_omp_team_pool_lock);
+    struct mir_omp_team_t* team = g_omp_team_pool;
+    if (team)
+        g_omp_team_pool = team->next;
+    mir_lock_unset(&g_omp_team_pool_lock);
+
+    if (team == NULL) {
+        team = mir_malloc_int(sizeof(struct mir_omp_team_t));
+        MIR_CHECK_MEM(team != NULL);
+        mir_barrier_init(&team->barrier, nthreads);
+        mir_lock_create(&(team->loop_lock));
+        team->started = 0;
+        team->generation = 0;
+        team->next_started = NULL;
+        for (int i = 0; i < MIR_WORKER_MAX_COUNT; i++) {
+            team->seen_generation[i] = 0;
+            team->blocks[i] = NULL;
+        }
+        team->members = NULL;
+    }
+    else if (team->num_threads != nthreads) {
+        mir_barrier_destroy(&team->barrier);
+        mir_barrier_init(&team->barrier, nthreads);
+    }
+
     team->prev = pteam;
+    team->next = NULL;
     team->single_count = nthreads;
     team->num_threads = nthreads;
-    mir_barrier_init(&team->barrier, team->num_threads);
     team->barrier_impending_count = 0;
-    mir_lock_create(&(team->loop_lock));
     team->loop = NULL;
-    for (int i = 0; i < MIR_WORKER_MAX_COUNT; i++)
+    // Only workers take part in teams
+    for (int i = 0; i < runtime->num_workers; i++)
         team->parallel_block_flag[i] = 0;
 
     return team;
 } /*}}}*/
+
+// The function mir_release_omp_team() returns a team to the pool
+// ... once its parallel region is joined.
+
+void mir_release_omp_team(struct mir_omp_team_t* team)
+{ /*{{{*/
+    MIR_ASSERT(team != NULL);
+
+    if (team->started == 1) {
+        mir_lock_set(&g_omp_teams_started_lock);
+        struct mir_omp_team_t* volatile* prev = &g_omp_teams_started;
+        while (*prev != team)
+            prev = &(*prev)->next_started;
+        *prev = team->next_started;
+        g_num_omp_teams_started--;
+        mir_lock_unset(&g_omp_teams_started_lock);
+        team->started = 0;
+    }
+
+    // Workers may still be looking at the team, they find no blocks in it
+    mir_lock_set(&g_omp_team_pool_lock);
+    team->next = g_omp_team_pool;
+    g_omp_team_pool = team;
+    mir_lock_unset(&g_omp_team_pool_lock);
+} /*}}}*/
+
+// The function mir_omp_team_start() starts a parallel region on the team.
+// A parallel block is created for each team member as a child of the
+// ... current task. Members claim their blocks when they see the
+// ... generation change, the caller joins them with mir_task_wait().
+
+void mir_omp_team_start(struct mir_omp_team_t* team, void* (*tfunc)(void*), void* data, size_t data_size, const char* name)
+{ /*{{{*/
+    MIR_ASSERT(team != NULL);
+    MIR_ASSERT(team->num_threads > 0 && team->num_threads <= runtime->num_workers);
+
+    // Blocks share the argument data
+    struct mir_task_t* blocks[MIR_WORKER_MAX_COUNT];
+    mir_task_create_siblings(tfunc, data, data_size, 0, team->num_threads, name, team, blocks);
+    for (int i = 0; i < team->num_threads; i++) {
+        MIR_ASSERT(team->blocks[i] == NULL);
+        team->blocks[i] = blocks[i];
+    }
+    team->members = blocks[0];
+    __sync_fetch_and_add(&g_num_tasks_waiting, team->num_threads);
+
+    if (team->started == 0) {
+        mir_lock_set(&g_omp_teams_started_lock);
+        team->next_started = g_omp_teams_started;
+        __sync_synchronize();
+        g_omp_teams_started = team;
+        g_num_omp_teams_started++;
+        mir_lock_unset(&g_omp_teams_started_lock);
+        team->started = 1;
+    }
+
+    // Broadcast
+    __sync_fetch_and_add(&team->generation, 1);
+
+    // Members of enclosing teams parked at a barrier claim their blocks
+    for (struct mir_omp_team_t* pteam = team->prev; pteam; pteam = pteam->prev)
+        mir_barrier_wake(&pteam->barrier);
+} /*}}}*/
+
+// The function mir_omp_team_pop() claims the parallel block of the worker
+// ... in a started team whose generation it has not seen yet.
+
+struct mir_task_t* mir_omp_team_pop(struct mir_worker_t* worker)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+
+    if (g_num_omp_teams_started == 0)
+        return NULL;
+
+    // Teams are not freed while workers run and a removed team keeps its
+    // ... link among started teams, which leads to teams started when it
+    // ... was removed, so walks never enter the pool and always end.
+    for (struct mir_omp_team_t* team = g_omp_teams_started; team; team = team->next_started) {
+        uint32_t generation = team->generation;
+        if (team->seen_generation[worker->id] == generation)
+            continue;
+        team->seen_generation[worker->id] = generation;
+        __sync_synchronize();
+
+        struct mir_task_t* task = __sync_lock_test_and_set(&team->blocks[worker->id], NULL);
+        if (task == NULL)
+            continue;
+
+        team->parallel_block_flag[worker->id] = 1;
+        __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
+        T_DBG("Dq", task);
+
+        // Update stats
+        if (runtime->enable_worker_stats == 1)
+            worker->statistics->num_tasks_owned++;
+
+        return task;
+    }
+
+    return NULL;
+} /*}}}*/
+
+// The function mir_omp_team_defer() sets aside a team task taken by a worker
+// ... that has not executed its parallel block. Members that have
+// ... executed theirs pick it up with mir_omp_team_pop_deferred().
+
+void mir_omp_team_defer(struct mir_task_t* task)
+{ /*{{{*/
+    MIR_ASSERT(task != NULL);
+    MIR_ASSERT(task->team != NULL);
+
+    struct mir_task_list_t* node = mir_malloc_int(sizeof(struct mir_task_list_t));
+    MIR_CHECK_MEM(node != NULL);
+    node->task = task;
+
+    // Deferred tasks are waiting tasks
+    __sync_fetch_and_add(&g_num_tasks_waiting, 1);
+
+    mir_lock_set(&g_omp_team_tasks_deferred_lock);
+    node->next = g_omp_team_tasks_deferred;
+    g_omp_team_tasks_deferred = node;
+    g_num_omp_team_tasks_deferred++;
+    mir_lock_unset(&g_omp_team_tasks_deferred_lock);
+    T_DBG("Df", task);
+} /*}}}*/
+
+// The function mir_omp_team_pop_deferred() retrieves a deferred task of a
+// ... team whose parallel block the worker has executed.
+// Tasks of other teams are skipped, not waited for.
+
+struct mir_task_t* mir_omp_team_pop_deferred(struct mir_worker_t* worker)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+
+    if (g_num_omp_team_tasks_deferred == 0)
+        return NULL;
+
+    if (mir_lock_tryset(&g_omp_team_tasks_deferred_lock) != 0)
+        return NULL;
+
+    struct mir_task_list_t** prev = &g_omp_team_tasks_deferred;
+    struct mir_task_list_t* node;
+    for (node = *prev; node; prev = &node->next, node = node->next) {
+        if (node->task->team->parallel_block_flag[worker->id] == 1) {
+            *prev = node->next;
+            g_num_omp_team_tasks_deferred--;
+            break;
+        }
+    }
+
+    mir_lock_unset(&g_omp_team_tasks_deferred_lock);
+
+    if (node == NULL)
+        return NULL;
+
+    struct mir_task_t* task = node->task;
+    mir_free_int(node, sizeof(struct mir_task_list_t));
+    __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
+    T_DBG("Dq", task);
+
+    // Update stats
+    if (runtime->enable_worker_stats == 1)
+        worker->statistics->num_tasks_stolen++;
+
+    return task;
+} /*}}}*/
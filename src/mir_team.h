@@ -1,25 +1,60 @@
 #ifndef MIR_TEAM_H
 #define MIR_TEAM_H 1
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "mir_barrier.h"
 #include "mir_lock.h"
 
 BEGIN_C_DECLS
 
+struct mir_task_t;
+struct mir_worker_t;
+
 typedef struct mir_omp_team_t mir_omp_team_t;
 
+// Teams are pooled and reused across parallel regions.
+// A region is started by bumping the generation word. Workers watching
+// started teams claim their parallel block when the generation changes.
 struct mir_omp_team_t { /*{{{*/
     struct mir_omp_team_t* prev;
-    pthread_barrier_t barrier;
+    struct mir_omp_team_t* next; // In the pool
+    // Among started teams. Kept when the team is removed, workers may
+    // ... still be walking through it.
+    struct mir_omp_team_t* volatile next_started;
+    struct mir_barrier_t barrier;
     int barrier_impending_count;
     int parallel_block_flag[MIR_WORKER_MAX_COUNT];
     int num_threads;
     int single_count;
     struct mir_lock_t loop_lock;
     struct mir_loop_des_t* loop;
+    int started;
+    volatile uint32_t generation;
+    // Generation last seen by each worker
+    uint32_t seen_generation[MIR_WORKER_MAX_COUNT];
+    // Parallel block of each worker, taken when claimed
+    struct mir_task_t* volatile blocks[MIR_WORKER_MAX_COUNT];
+    // Parallel blocks of the region, allocated in member order
+    struct mir_task_t* members;
 }; /*}}}*/
 
+void mir_omp_team_pool_create();
+
+void mir_omp_team_pool_destroy();
+
 struct mir_omp_team_t* mir_new_omp_team(struct mir_omp_team_t*, unsigned);
 
+void mir_release_omp_team(struct mir_omp_team_t* team);
+
+void mir_omp_team_start(struct mir_omp_team_t* team, void* (*tfunc)(void*), void* data, size_t data_size, const char* name);
+
+struct mir_task_t* mir_omp_team_pop(struct mir_worker_t* worker);
+
+void mir_omp_team_defer(struct mir_task_t* task);
+
+struct mir_task_t* mir_omp_team_pop_deferred(struct mir_worker_t* worker);
+
 END_C_DECLS
 #endif
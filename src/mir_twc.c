@@ -3,6 +3,30 @@
 #include "mir_utils.h"
 #include "mir_runtime.h"
 
+// The function mir_twc_reduce() returns 1 when all counted tasks are done.
+
+unsigned int mir_twc_reduce(struct mir_twc_t* twc)
+{ /*{{{*/
+    volatile unsigned long sum = 0;
+    for (int i = 0; i < runtime->num_workers; i++)
+        sum += twc->count_per_worker[i];
+
+    // This catches the nasty case of not sychronizing with all tasks previously
+    MIR_ASSERT(sum <= twc->count);
+
+    if (sum < twc->count)
+        return 0;
+    else
+        return 1; // sum == twc->count
+} /*}}}*/
+
+// The function mir_twc_done() is mir_twc_reduce() as a wait condition.
+
+int mir_twc_done(void* twc)
+{ /*{{{*/
+    return mir_twc_reduce((struct mir_twc_t*)twc);
+} /*}}}*/
+
 struct mir_twc_t* mir_twc_create()
 { /*{{{*/
     struct mir_twc_t* twc = mir_malloc_int(sizeof(struct mir_twc_t));
@@ -12,6 +36,7 @@ struct mir_twc_t* mir_twc_create()
     for (int i = 0; i < runtime->num_workers; i++)
         twc->count_per_worker[i] = 0;
     twc->count = 0;
+    twc->thief = -1;
 
     // Reset num times passed
     twc->num_passes = 0;
@@ -22,3 +47,17 @@ struct mir_twc_t* mir_twc_create()
 
     return twc;
 } /*}}}*/
+
+void mir_twc_destroy(struct mir_twc_t* twc)
+{ /*{{{*/
+    MIR_ASSERT(twc != NULL);
+
+    struct mir_time_list_t* tl = twc->pass_time;
+    while (tl) {
+        struct mir_time_list_t* next = tl->next;
+        mir_free_int(tl, sizeof(struct mir_time_list_t));
+        tl = next;
+    }
+
+    mir_free_int(twc, sizeof(struct mir_twc_t));
+} /*}}}*/
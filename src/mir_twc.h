@@ -12,10 +12,18 @@ struct mir_twc_t { /*{{{*/
     unsigned long num_passes;
     struct mir_time_list_t* pass_time;
     unsigned int count_per_worker[MIR_WORKER_MAX_COUNT];
+    // Worker that last took a child away from the waiter, -1 if none
+    volatile int thief;
 }; /*}}}*/
 
 struct mir_twc_t* mir_twc_create();
 
+void mir_twc_destroy(struct mir_twc_t* twc);
+
+unsigned int mir_twc_reduce(struct mir_twc_t* twc);
+
+int mir_twc_done(void* twc);
+
 END_C_DECLS
 
 #endif
@@ -9,6 +9,7 @@
 #include "arch/mir_arch.h"
 #include "scheduling/mir_sched_pol.h"
 #include "mir_task_queue.h"
+#include "mir_fiber.h"
 
 #ifdef __tile__
 #include <tmc/cpus.h>
@@ -18,6 +19,7 @@
 // FIXME: Make these per-worker
 // PJ says kill the thread upon exit
 uint32_t g_worker_status_board = 0;
+uint32_t g_num_prio_tasks_waiting = 0;
 uint32_t g_num_tasks_waiting = 0;
 
 extern uint32_t g_sig_worker_alive;
@@ -58,6 +60,10 @@ static void* mir_worker_loop(void* arg)
 
     // Now do useful work
     while (1) {
+        // Contexts that lent the worker to others go first
+        if (runtime->enable_fibers == 1 && mir_fiber_yield(worker) == 1)
+            continue;
+
         // Do work with backoff=1
         mir_worker_do_work(worker, 1);
 
@@ -116,6 +122,17 @@ struct mir_worker_t* mir_worker_get_context()
     return worker;
 } /*}}}*/
 
+// The function mir_worker_try_get_context() returns NULL
+// when called from a thread that is not a worker.
+
+struct mir_worker_t* mir_worker_try_get_context()
+{ /*{{{*/
+    if (runtime == NULL)
+        return NULL;
+
+    return pthread_getspecific(runtime->worker_index);
+} /*}}}*/
+
 static int worker_get_cpu_affinity()
 { /*{{{*/
     cpu_set_t set;
@@ -193,6 +210,22 @@ void mir_worker_local_init(struct mir_worker_t* worker)
     // Create private task queue
     worker->private_queue = mir_task_queue_create(runtime->sched_pol->queue_capacity);
     MIR_CHECK_MEM(worker->private_queue != NULL);
+    worker->inject_poll_count = 0;
+
+    // Create priority level queues
+    worker->prio_queues[0] = NULL;
+    for (int i = 1; i < MIR_TASK_PRIORITY_LEVELS; i++) {
+        worker->prio_queues[i] = mir_task_queue_create(MIR_TASK_PRIORITY_QUEUE_CAPACITY);
+        MIR_CHECK_MEM(worker->prio_queues[i] != NULL);
+    }
+    worker->bundle = NULL;
+    worker->wait_depth = 0;
+    worker->help_misses = 0;
+    worker->fiber = NULL;
+    worker->fibers_suspended = NULL;
+    worker->fibers_idle = NULL;
+    worker->fibers_free = NULL;
+    worker->omp_lock_spin_count = MIR_OMP_LOCK_SPIN_COUNT;
 
     // Kill signal
     // Used during runtime system shutdown
@@ -234,24 +267,127 @@ void mir_worker_push(struct mir_worker_t* worker, struct mir_task_t* task)
     }
 } /*}}}*/
 
-// The function mir_worker_pop() retrieves a task
-// from the private task queue of the worker in FIFO order.
+// The function mir_worker_schedule() pushes a task to the priority level queue
+// ... of the worker or, for priority 0 tasks, to the scheduling policy.
 
-static inline struct mir_task_t* mir_worker_pop(struct mir_worker_t* worker)
+int mir_worker_schedule(struct mir_worker_t* worker, struct mir_task_t* task)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+    MIR_ASSERT(task != NULL);
+
+    if (task->priority > 0) {
+        MIR_ASSERT(task->priority < MIR_TASK_PRIORITY_LEVELS);
+        if (1 == mir_task_queue_push(worker->prio_queues[task->priority], task)) {
+            __sync_fetch_and_add(&g_num_tasks_waiting, 1);
+            __sync_fetch_and_add(&g_num_prio_tasks_waiting, 1);
+            // Update stats
+            if (runtime->enable_worker_stats == 1)
+                worker->statistics->num_tasks_created++;
+            return 1;
+        }
+        // Level is full, the policy takes the task
+    }
+
+    return runtime->sched_pol->push(worker, task);
+} /*}}}*/
+
+// The function mir_worker_schedule_many() pushes priority 0 tasks without
+// ... affinity hints to the scheduling policy in bulk, if it supports that.
+
+int mir_worker_schedule_many(struct mir_worker_t* worker, struct mir_task_t** tasks, unsigned int num_tasks)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+    MIR_ASSERT(tasks != NULL);
+
+    if (runtime->sched_pol->push_many)
+        return runtime->sched_pol->push_many(worker, tasks, num_tasks);
+
+    int pushed = 0;
+    for (unsigned int i = 0; i < num_tasks; i++)
+        pushed += mir_worker_schedule(worker, tasks[i]);
+
+    return pushed;
+} /*}}}*/
+
+// The function mir_worker_pop_prio() retrieves the highest priority task.
+// Own queues are checked first at each level, then other workers' queues.
+// Given an ancestor, only its descendants are taken from the queue heads.
+
+static inline struct mir_task_t* mir_worker_pop_prio(struct mir_worker_t* worker, const struct mir_task_t* ancestor)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+
+    if (g_num_prio_tasks_waiting == 0)
+        return NULL;
+
+    for (int level = MIR_TASK_PRIORITY_LEVELS - 1; level > 0; level--) {
+        int id = worker->id;
+        do {
+            struct mir_task_queue_t* queue = runtime->workers[id].prio_queues[level];
+            if (mir_task_queue_size(queue) > 0) {
+                struct mir_task_t* task = ancestor ? mir_task_queue_pop_descendant(queue, ancestor) : mir_task_queue_pop(queue);
+                if (task) {
+                    __sync_fetch_and_sub(&g_num_prio_tasks_waiting, 1);
+                    __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
+                    T_DBG(id == worker->id ? "Dq" : "St", task);
+
+                    // Update stats
+                    if (runtime->enable_worker_stats == 1) {
+                        if (id == worker->id)
+                            worker->statistics->num_tasks_owned++;
+                        else
+                            worker->statistics->num_tasks_stolen++;
+                    }
+
+                    return task;
+                }
+            }
+            id = (id + 1) % runtime->num_workers;
+        } while (id != worker->id);
+    }
+
+    return NULL;
+} /*}}}*/
+
+// The function mir_worker_pop() retrieves a parallel block started for
+// the worker or a task from the private task queue of the worker in FIFO order.
+// Given an ancestor, only its descendants are taken from the queue head.
+// The parallel block of the worker is always taken, the team waits for it.
+
+static inline struct mir_task_t* mir_worker_pop(struct mir_worker_t* worker, const struct mir_task_t* ancestor)
 { /*{{{*/
     MIR_ASSERT(worker != NULL);
 
     struct mir_task_queue_t* queue = worker->private_queue;
     MIR_ASSERT(queue != NULL);
+
+    // Parallel blocks come before other tasks of their team.
+    // Teams are looked at after the queue size, so a block is found
+    // ... before any task its team pushed to this queue.
     if (mir_task_queue_size(queue) == 0)
-        return NULL;
+        return mir_omp_team_pop(worker);
+    struct mir_task_t* task = mir_omp_team_pop(worker);
+    if (task)
+        return task;
 
     // Ensure the queue pops in FIFO order.
-    struct mir_task_t* task = mir_task_queue_pop(queue);
-    MIR_ASSERT(task != NULL);
+    if (ancestor) {
+        task = mir_task_queue_pop_descendant(queue, ancestor);
+        if (task == NULL)
+            return NULL;
+    }
+    else {
+        task = mir_task_queue_pop(queue);
+        MIR_ASSERT(task != NULL);
+    }
     __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
     T_DBG("Dq", task);
 
+    // The private queue is FIFO ordered. We have either already
+    // executed the parallel block or will execute it right now.
+    if (task->team)
+        task->team->parallel_block_flag[worker->id] = 1;
+
     // Update stats
     if (runtime->enable_worker_stats == 1)
         worker->statistics->num_tasks_owned++;
@@ -259,22 +395,99 @@ static inline struct mir_task_t* mir_worker_pop(struct mir_worker_t* worker)
     return task;
 } /*}}}*/
 
+// The function mir_worker_pop_injected() retrieves a task
+// submitted by a thread outside the runtime.
+// Given an ancestor, only its descendants are taken from the queue head.
+
+static inline struct mir_task_t* mir_worker_pop_injected(struct mir_worker_t* worker, const struct mir_task_t* ancestor)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+
+    struct mir_task_queue_t* queue = runtime->inject_queue;
+    MIR_ASSERT(queue != NULL);
+    if (mir_task_queue_size(queue) == 0)
+        return NULL;
+
+    struct mir_task_t* task = ancestor ? mir_task_queue_pop_descendant(queue, ancestor) : mir_task_queue_pop(queue);
+    if (task == NULL)
+        return NULL;
+    __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
+    T_DBG("Dq", task);
+
+    // Update stats
+    if (runtime->enable_worker_stats == 1)
+        worker->statistics->num_tasks_owned++;
+
+    return task;
+} /*}}}*/
+
+// The function mir_worker_admit() returns the task if the worker may execute it.
+// Team tasks taken before the worker has executed its parallel block are
+// ... deferred to the team instead, so they do not hold up the queue they
+// ... were taken from.
+
+static inline struct mir_task_t* mir_worker_admit(struct mir_worker_t* worker, struct mir_task_t* task)
+{ /*{{{*/
+#ifdef MIR_GPL
+    if (task == NULL || task->team == NULL || runtime->single_parallel_block)
+        return task;
+
+    if (task->team->parallel_block_flag[worker->id] == 1)
+        return task;
+
+    mir_omp_team_defer(task);
+
+    return NULL;
+#else
+    return task;
+#endif
+} /*}}}*/
+
 static inline struct mir_task_t* mir_pop(struct mir_worker_t* worker)
 { /*{{{*/
-    struct mir_task_t *tmp = mir_worker_pop(worker);
+    struct mir_task_t *tmp = mir_worker_pop(worker, NULL);
 
     if (tmp)
         return tmp;
 
-    if (runtime->sched_pol->pop(&tmp))
+    // Team tasks deferred by other workers
+    tmp = mir_omp_team_pop_deferred(worker);
+    if (tmp)
         return tmp;
-    return NULL;
+
+    // Poll injected tasks now and then so that
+    // ... external submitters are not starved by internal work.
+    if (++worker->inject_poll_count >= MIR_WORKER_INJECT_POLL_INTERVAL) {
+        worker->inject_poll_count = 0;
+        tmp = mir_worker_admit(worker, mir_worker_pop_injected(worker, NULL));
+        if (tmp)
+            return tmp;
+    }
+
+    tmp = mir_worker_admit(worker, mir_worker_pop_prio(worker, NULL));
+    if (tmp)
+        return tmp;
+
+    if (runtime->sched_pol->pop(&tmp))
+        return mir_worker_admit(worker, tmp);
+
+    return mir_worker_admit(worker, mir_worker_pop_injected(worker, NULL));
 } /*}}}*/
 
 void mir_worker_do_work(struct mir_worker_t* worker, int backoff)
 { /*{{{*/
     MIR_ASSERT(worker != NULL);
 
+    // Tiny tasks are not held back while workers look for work
+    if (worker->bundle)
+        mir_task_bundle_flush(worker);
+
+    // Waiting tasks whose children are done come before new tasks
+    if (runtime->enable_fibers == 1 && mir_fiber_resume_ready(worker) == 1) {
+        mir_worker_backoff_reset(worker);
+        return;
+    }
+
     // Overhead measurement
     uint64_t start_instant = mir_get_cycles();
 
@@ -316,9 +529,177 @@ void mir_worker_do_work(struct mir_worker_t* worker, int backoff)
         worker->current_task->overhead_cycles += (mir_get_cycles() - start_instant);
 } /*}}}*/
 
+// The function mir_pop_leapfrog() retrieves a descendant of the waiting
+// ... task from this worker's queue or, failing that, from the worker that
+// ... last took a child (leapfrogging). Only policies implementing pop_from
+// ... support this.
+
+static inline struct mir_task_t* mir_pop_leapfrog(struct mir_worker_t* worker, struct mir_task_t* waiter, struct mir_twc_t* twc)
+{ /*{{{*/
+    struct mir_sched_pol_t* sp = runtime->sched_pol;
+    struct mir_task_t* task = NULL;
+
+    if (sp->pop_from == NULL)
+        return NULL;
+
+    if (1 == sp->pop_from(worker, worker->id, waiter, &task))
+        return mir_worker_admit(worker, task);
+
+    int thief = twc ? twc->thief : -1;
+    if (thief >= 0 && thief != worker->id && 1 == sp->pop_from(worker, thief, waiter, &task))
+        return mir_worker_admit(worker, task);
+
+    return NULL;
+} /*}}}*/
+
+// The function mir_pop_descendant() retrieves a descendant of the waiting
+// ... task from any queue the worker may take from. Priority tasks come
+// ... first, then leapfrogging, then the queues of other workers.
+// Only the tasks next in line are looked at, others stay where they are.
+
+static inline struct mir_task_t* mir_pop_descendant(struct mir_worker_t* worker, struct mir_task_t* waiter, struct mir_twc_t* twc)
+{ /*{{{*/
+    struct mir_sched_pol_t* sp = runtime->sched_pol;
+    struct mir_task_t* task = mir_worker_admit(worker, mir_worker_pop_prio(worker, waiter));
+    if (task)
+        return task;
+
+    task = mir_pop_leapfrog(worker, waiter, twc);
+    if (task)
+        return task;
+
+    task = mir_worker_pop(worker, waiter);
+    if (task)
+        return task;
+
+    if (sp->pop_from) {
+        for (int i = 1; i < runtime->num_workers; i++) {
+            uint16_t victim = (worker->id + i) % runtime->num_workers;
+            if (1 == sp->pop_from(worker, victim, waiter, &task))
+                return mir_worker_admit(worker, task);
+        }
+    }
+
+    return mir_worker_admit(worker, mir_worker_pop_injected(worker, waiter));
+} /*}}}*/
+
+// The function mir_worker_help() does work on behalf of a task waiting
+// ... for its children, counted by twc, or for another condition, where
+// ... twc is NULL and the worker does not leapfrog. Priority tasks,
+// ... hinted tasks and injected tasks keep their precedence while task
+// ... waits are nested within the depth limit. Otherwise descendants of the waiting task are taken first.
+// Beyond the depth limit the waiter backs off when no descendant is next
+// ... in line, and takes any task only after MIR_WORKER_HELP_MISS_LIMIT
+// ... such misses. Waits thus nest slowly instead of without bound, while
+// ... tasks the waiter depends on that do not descend from it, such as
+// ... continuations or dependent tasks, still get to run.
+
+void mir_worker_help(struct mir_worker_t* worker, struct mir_twc_t* twc, int backoff)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+
+    struct mir_sched_pol_t* sp = runtime->sched_pol;
+    struct mir_task_t* waiter = worker->current_task;
+    if (waiter == NULL) {
+        mir_worker_do_work(worker, backoff);
+        return;
+    }
+
+    int within_limit = worker->wait_depth <= runtime->wait_depth_limit;
+    // Within the limit, work that jumps the queue comes before leapfrogging
+    // Mailboxes hold the tasks hinted to a worker.
+    if (within_limit &&
+        (sp->pop_from == NULL ||
+         g_num_prio_tasks_waiting > 0 ||
+         mir_task_queue_size(runtime->inject_queue) > 0 ||
+         mir_sched_pol_mailbox_size(worker->id) > 0)) {
+        mir_worker_do_work(worker, backoff);
+        return;
+    }
+
+    // Tiny tasks are not held back while workers look for work
+    if (worker->bundle)
+        mir_task_bundle_flush(worker);
+
+    // Waiting tasks whose children are done continue on their own stacks
+    if (runtime->enable_fibers == 1 && mir_fiber_resume_ready(worker) == 1) {
+        mir_worker_backoff_reset(worker);
+        return;
+    }
+
+    // Overhead measurement
+    uint64_t start_instant = mir_get_cycles();
+
+    struct mir_task_t* task = within_limit ? mir_pop_leapfrog(worker, waiter, twc) : mir_pop_descendant(worker, waiter, twc);
+
+    // Overhead measurement
+    waiter->overhead_cycles += (mir_get_cycles() - start_instant);
+
+    if (task) {
+        worker->help_misses = 0;
+
+        // Update busy counter
+        __sync_fetch_and_add(&g_worker_status_board, 1);
+
+        // Execute task
+        mir_task_execute(task);
+
+        // Update busy counter
+        __sync_fetch_and_sub(&g_worker_status_board, 1);
+
+        // Update backoff
+        mir_worker_backoff_reset(worker);
+
+        return;
+    }
+
+    if (within_limit || ++worker->help_misses >= MIR_WORKER_HELP_MISS_LIMIT) {
+        worker->help_misses = 0;
+        mir_worker_do_work(worker, backoff);
+        return;
+    }
+
+    if (backoff)
+        mir_worker_backoff(worker);
+} /*}}}*/
+
+// The function mir_worker_help_team() executes a task for a team member
+// ... waiting at a barrier: a descendant of ancestor, or a parallel block
+// ... of a nested team, which only this worker can claim. Other tasks are
+// ... left to workers not held up by the team.
+// Returns 0 if there is none.
+
+int mir_worker_help_team(struct mir_worker_t* worker, const struct mir_task_t* ancestor)
+{ /*{{{*/
+    MIR_ASSERT(worker != NULL);
+    MIR_ASSERT(ancestor != NULL);
+
+    // Blocks of this worker are claimed before its queue is searched
+    struct mir_task_t* task = mir_pop_descendant(worker, (struct mir_task_t*)ancestor, NULL);
+    if (task == NULL)
+        return 0;
+
+    // Update busy counter
+    __sync_fetch_and_add(&g_worker_status_board, 1);
+
+    // Execute task
+    mir_task_execute(task);
+
+    // Update busy counter
+    __sync_fetch_and_sub(&g_worker_status_board, 1);
+
+    return 1;
+} /*}}}*/
+
 void mir_worker_check_done()
 { /*{{{*/
+    // Contexts suspended on the calling worker are resumed only by it
+    struct mir_worker_t* worker = mir_worker_try_get_context();
+
     while (1) {
+        if (runtime->enable_fibers == 1 && worker && (mir_fiber_resume_ready(worker) == 1 || mir_fiber_yield(worker) == 1))
+            continue;
+
         //mir_sleep_ms(300); // Butterfly effect!
         __sync_synchronize();
         // Check if worker is free and no tasks are queued up
@@ -351,6 +732,7 @@ void mir_worker_statistics_init(struct mir_worker_statistics_t* statistics)
     statistics->num_tasks_owned = 0;
     statistics->num_tasks_stolen = 0;
     statistics->num_tasks_inlined = 0;
+    statistics->num_tasks_bundled = 0;
     statistics->num_comm_tasks = 0;
     statistics->total_comm_cost = 0;
     statistics->lowest_comm_cost = -1;
@@ -390,7 +772,7 @@ void mir_worker_statistics_update_comm_cost(struct mir_worker_statistics_t* stat
 
 void mir_worker_statistics_write_header_to_file(FILE* file)
 { /*{{{*/
-    fprintf(file, "worker,created,owned,stolen,inlined,comm_tasks,total_comm_cost,avg_comm_cost,lowest_comm_cost,highest_comm_cost,comm_tasks_stolen_by_diameter\n");
+    fprintf(file, "worker,created,owned,stolen,inlined,bundled,comm_tasks,total_comm_cost,avg_comm_cost,lowest_comm_cost,highest_comm_cost,comm_tasks_stolen_by_diameter\n");
 } /*}}}*/
 
 void mir_worker_statistics_write_to_file(const struct mir_worker_statistics_t* statistics, FILE* file)
@@ -406,12 +788,13 @@ void mir_worker_statistics_write_to_file(const struct mir_worker_statistics_t* s
 
     // Dump to file
     if (statistics->num_comm_tasks_stolen_by_diameter) {
-        fprintf(file, "%d,%d,%d,%d,%d,%d,%lu,%lu,%lu,%lu",
+        fprintf(file, "%d,%d,%d,%d,%d,%d,%d,%lu,%lu,%lu,%lu",
             statistics->id,
             statistics->num_tasks_created,
             statistics->num_tasks_owned,
             statistics->num_tasks_stolen,
             statistics->num_tasks_inlined,
+            statistics->num_tasks_bundled,
             statistics->num_comm_tasks,
             statistics->total_comm_cost,
             avg_comm_cost,
@@ -423,12 +806,13 @@ void mir_worker_statistics_write_to_file(const struct mir_worker_statistics_t* s
         fprintf(file, "]\n");
     }
     else {
-        fprintf(file, "%d,%d,%d,%d,%d,%d,%lu,%lu,%lu,%lu,NA\n",
+        fprintf(file, "%d,%d,%d,%d,%d,%d,%d,%lu,%lu,%lu,%lu,NA\n",
             statistics->id,
             statistics->num_tasks_created,
             statistics->num_tasks_owned,
             statistics->num_tasks_stolen,
             statistics->num_tasks_inlined,
+            statistics->num_tasks_bundled,
             statistics->num_comm_tasks,
             statistics->total_comm_cost,
             avg_comm_cost,
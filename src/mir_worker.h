@@ -14,8 +14,12 @@
 
 BEGIN_C_DECLS
 
+struct mir_twc_t;
+struct mir_fiber_t;
+
 extern uint32_t g_worker_status_board;
 extern uint32_t g_num_tasks_waiting;
+extern uint32_t g_num_prio_tasks_waiting;
 
 struct mir_worker_statistics_t {
     uint16_t id;
@@ -24,6 +28,7 @@ struct mir_worker_statistics_t {
     uint32_t num_tasks_owned;
     uint32_t num_tasks_stolen;
     uint32_t num_tasks_inlined;
+    uint32_t num_tasks_bundled;
     // These are specific to tasks with communication costs
     uint32_t num_comm_tasks;
     unsigned long total_comm_cost;
@@ -47,6 +52,25 @@ struct mir_worker_t {
     // such as OMP for loop and parallel block tasks.
     // It is crucial that tasks are retreived in FIFO order from the private task queue.
     struct mir_task_queue_t* private_queue;
+    // Pops since the runtime injection queue was last polled
+    uint32_t inject_poll_count;
+    // Queues for tasks with priority above 0, one per level
+    // Level 0 is unused. Other workers steal from these before the scheduling policy.
+    struct mir_task_queue_t* prio_queues[MIR_TASK_PRIORITY_LEVELS];
+    // Tiny tasks gathered so far, not yet scheduled
+    struct mir_task_bundle_t* bundle;
+    // Task waits in progress on this worker's stack
+    uint32_t wait_depth;
+    // Searches for descendants beyond the depth limit that found none
+    uint32_t help_misses;
+    // Context being executed, NULL until a task suspends on this worker
+    struct mir_fiber_t* fiber;
+    // Contexts waiting for a condition, for the worker when another is done with it, and unused stacks
+    struct mir_fiber_t* fibers_suspended;
+    struct mir_fiber_t* fibers_idle;
+    struct mir_fiber_t* fibers_free;
+    // Spins before parking on a held OpenMP lock
+    int omp_lock_spin_count;
     // For task statistics
     struct mir_task_list_t* task_list;
 };
@@ -61,10 +85,16 @@ void mir_worker_local_init(struct mir_worker_t* worker);
 
 void mir_worker_do_work(struct mir_worker_t* worker, int backoff);
 
+void mir_worker_help(struct mir_worker_t* worker, struct mir_twc_t* twc, int backoff);
+
+int mir_worker_help_team(struct mir_worker_t* worker, const struct mir_task_t* ancestor);
+
 void mir_worker_check_done();
 
 struct mir_worker_t* mir_worker_get_context();
 
+struct mir_worker_t* mir_worker_try_get_context();
+
 void mir_worker_statistics_init(struct mir_worker_statistics_t* statistics);
 
 void mir_worker_statistics_destroy(struct mir_worker_statistics_t* statistics);
@@ -79,5 +109,9 @@ void mir_worker_update_task_list(struct mir_worker_t* worker, struct mir_task_t*
 
 void mir_worker_push(struct mir_worker_t* worker, struct mir_task_t* task);
 
+int mir_worker_schedule(struct mir_worker_t* worker, struct mir_task_t* task);
+
+int mir_worker_schedule_many(struct mir_worker_t* worker, struct mir_task_t** tasks, unsigned int num_tasks);
+
 END_C_DECLS
 #endif
@@ -1,4 +1,10 @@
 #include "scheduling/mir_sched_pol.h"
+#include "mir_runtime.h"
+#include "mir_worker.h"
+#include "mir_task.h"
+#include "mir_task_queue.h"
+#include "mir_memory.h"
+#include "mir_utils.h"
 #include "mir_defines.h"
 
 #include <string.h>
@@ -32,3 +38,145 @@ struct mir_sched_pol_t* mir_sched_pol_get_by_name(const char* name)
     }
 } /*}}}*/
 
+
+void mir_sched_pol_create_mailboxes()
+{ /*{{{*/
+    struct mir_sched_pol_t* sp = runtime->sched_pol;
+    MIR_ASSERT(NULL != sp);
+
+    sp->alt_queues = mir_malloc_int(runtime->num_workers * sizeof(struct mir_task_queue_t*));
+    MIR_CHECK_MEM(NULL != sp->alt_queues);
+
+    for (int i = 0; i < runtime->num_workers; i++) {
+        sp->alt_queues[i] = (struct mir_queue_t*)mir_task_queue_create(sp->queue_capacity);
+        MIR_ASSERT(NULL != sp->alt_queues[i]);
+    }
+    sp->has_mailboxes = 1;
+} /*}}}*/
+
+void mir_sched_pol_destroy_mailboxes()
+{ /*{{{*/
+    struct mir_sched_pol_t* sp = runtime->sched_pol;
+    MIR_ASSERT(NULL != sp);
+    MIR_ASSERT(NULL != sp->alt_queues);
+
+    for (int i = 0; i < runtime->num_workers; i++) {
+        mir_task_queue_destroy((struct mir_task_queue_t*)sp->alt_queues[i]);
+        sp->alt_queues[i] = NULL;
+    }
+
+    mir_free_int(sp->alt_queues, runtime->num_workers * sizeof(struct mir_task_queue_t*));
+    sp->alt_queues = NULL;
+    sp->has_mailboxes = 0;
+} /*}}}*/
+
+// The function mir_sched_pol_affinity_target() returns the worker a task
+// ... is hinted to, or -1 if the task is best kept by this worker.
+
+int mir_sched_pol_affinity_target(struct mir_worker_t* worker, struct mir_task_t* task)
+{ /*{{{*/
+    MIR_ASSERT(NULL != worker);
+    MIR_ASSERT(NULL != task);
+
+    if (task->affinity_worker >= 0)
+        return task->affinity_worker == worker->id ? -1 : task->affinity_worker;
+
+    if (task->affinity_node < 0)
+        return -1;
+
+    if (runtime->arch->node_of(worker->cpu_id) == task->affinity_node)
+        return -1;
+
+    // Spread over workers of the node
+    int i = worker->bias;
+    do {
+        if (runtime->arch->node_of(runtime->workers[i].cpu_id) == task->affinity_node) {
+            mir_worker_update_bias(worker);
+            return i;
+        }
+        i = (i + 1) % runtime->num_workers;
+    } while (i != worker->bias);
+
+    // No worker on node
+    return -1;
+} /*}}}*/
+
+int mir_sched_pol_push_mailbox(struct mir_worker_t* worker, struct mir_task_t* task, uint16_t to)
+{ /*{{{*/
+    MIR_ASSERT(NULL != worker);
+    MIR_ASSERT(NULL != task);
+    MIR_ASSERT(to < runtime->num_workers);
+
+    struct mir_task_queue_t* queue = (struct mir_task_queue_t*)runtime->sched_pol->alt_queues[to];
+    MIR_ASSERT(NULL != queue);
+    if (0 == mir_task_queue_push(queue, task))
+        return 0;
+
+    __sync_fetch_and_add(&g_num_tasks_waiting, 1);
+    // Update stats
+    if (runtime->enable_worker_stats == 1)
+        worker->statistics->num_tasks_created++;
+
+    return 1;
+} /*}}}*/
+
+static inline int take_mailbox(struct mir_worker_t* worker, uint16_t from, struct mir_task_t* task)
+{ /*{{{*/
+    if (!task)
+        return 0;
+
+    // Update stats
+    if (runtime->enable_worker_stats == 1) {
+        if (from == worker->id)
+            worker->statistics->num_tasks_owned++;
+        else
+            worker->statistics->num_tasks_stolen++;
+    }
+
+    __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
+    T_DBG(from == worker->id ? "Dq" : "St", task);
+
+    return 1;
+} /*}}}*/
+
+int mir_sched_pol_pop_mailbox(struct mir_worker_t* worker, uint16_t from, struct mir_task_t** task)
+{ /*{{{*/
+    MIR_ASSERT(NULL != worker);
+    MIR_ASSERT(from < runtime->num_workers);
+
+    struct mir_task_queue_t* queue = (struct mir_task_queue_t*)runtime->sched_pol->alt_queues[from];
+    MIR_ASSERT(NULL != queue);
+    if (mir_task_queue_size(queue) == 0)
+        return 0;
+
+    *task = mir_task_queue_pop(queue);
+
+    return take_mailbox(worker, from, *task);
+} /*}}}*/
+
+int mir_sched_pol_pop_mailbox_descendant(struct mir_worker_t* worker, uint16_t from, const struct mir_task_t* ancestor, struct mir_task_t** task)
+{ /*{{{*/
+    MIR_ASSERT(NULL != worker);
+    MIR_ASSERT(from < runtime->num_workers);
+
+    struct mir_task_queue_t* queue = (struct mir_task_queue_t*)runtime->sched_pol->alt_queues[from];
+    MIR_ASSERT(NULL != queue);
+    if (mir_task_queue_size(queue) == 0)
+        return 0;
+
+    *task = mir_task_queue_pop_descendant(queue, ancestor);
+
+    return take_mailbox(worker, from, *task);
+} /*}}}*/
+
+uint32_t mir_sched_pol_mailbox_size(uint16_t of)
+{ /*{{{*/
+    struct mir_sched_pol_t* sp = runtime->sched_pol;
+    MIR_ASSERT(NULL != sp);
+    MIR_ASSERT(of < runtime->num_workers);
+
+    if (sp->has_mailboxes == 0)
+        return 0;
+
+    return mir_task_queue_size((struct mir_task_queue_t*)sp->alt_queues[of]);
+} /*}}}*/
@@ -25,6 +25,7 @@ struct mir_sched_pol_t {
     // Data structures
     struct mir_queue_t** queues;
     struct mir_queue_t** alt_queues;
+    int has_mailboxes; // alt_queues are affinity mailboxes
     uint16_t num_queues;
     uint32_t queue_capacity;
     const char* name;
@@ -34,11 +35,34 @@ struct mir_sched_pol_t {
     void (*create)();
     void (*destroy)();
     int (*push)(struct mir_worker_t*, struct mir_task_t*);
+    // Optional. Pushes tasks without priority or affinity hints in bulk.
+    int (*push_many)(struct mir_worker_t*, struct mir_task_t**, unsigned int);
     int (*pop)(struct mir_task_t**);
+    // Takes a descendant of the given task from the queues of one worker
+    // ... without disturbing other tasks. Queues shared by workers are
+    // ... looked at for the calling worker only.
+    int (*pop_from)(struct mir_worker_t*, uint16_t, struct mir_task_t*, struct mir_task_t**);
 };
 
 struct mir_sched_pol_t* mir_sched_pol_get_by_name(const char* name);
 
+// Affinity mailboxes are per-worker task queues in alt_queues.
+// They hold tasks hinted to a worker or node other than their creator's.
+void mir_sched_pol_create_mailboxes();
+
+void mir_sched_pol_destroy_mailboxes();
+
+int mir_sched_pol_affinity_target(struct mir_worker_t* worker, struct mir_task_t* task);
+
+int mir_sched_pol_push_mailbox(struct mir_worker_t* worker, struct mir_task_t* task, uint16_t to);
+
+int mir_sched_pol_pop_mailbox(struct mir_worker_t* worker, uint16_t from, struct mir_task_t** task);
+
+int mir_sched_pol_pop_mailbox_descendant(struct mir_worker_t* worker, uint16_t from, const struct mir_task_t* ancestor, struct mir_task_t** task);
+
+// Returns 0 if the policy has no mailboxes.
+uint32_t mir_sched_pol_mailbox_size(uint16_t of);
+
 END_C_DECLS
 
 #endif
@@ -78,48 +78,94 @@ int push_central(struct mir_worker_t* worker, struct mir_task_t* task)
     return pushed;
 } /*}}}*/
 
-int pop_central(struct mir_task_t** task)
+int push_many_central(struct mir_worker_t* worker, struct mir_task_t** tasks, unsigned int num_tasks)
 { /*{{{*/
-    //MIR_RECORDER_STATE_BEGIN(MIR_STATE_TMOBING);
+    MIR_ASSERT(NULL != tasks);
+    MIR_ASSERT(NULL != worker);
 
-    struct mir_sched_pol_t* sp = runtime->sched_pol;
-    MIR_ASSERT(NULL != sp);
-    struct mir_queue_t* queue = sp->queues[0];
+    // Push tasks to central queue in one go
+    struct mir_task_queue_t* queue = (struct mir_task_queue_t *)runtime->sched_pol->queues[0];
     MIR_ASSERT(NULL != queue);
-    if (mir_queue_size(queue) == 0) {
-        return 0;
-    }
+    unsigned int pushed = mir_task_queue_push_many(queue, tasks, num_tasks);
+    __sync_fetch_and_add(&g_num_tasks_waiting, pushed);
+    // Update stats
+    if (runtime->enable_worker_stats == 1)
+        worker->statistics->num_tasks_created += pushed;
 
-    struct mir_worker_t* worker = mir_worker_get_context();
-    MIR_ASSERT(NULL != worker);
+    // Tasks that did not fit take the single push path
+    for (unsigned int i = pushed; i < num_tasks; i++)
+        pushed += push_central(worker, tasks[i]);
 
-    *task = NULL;
-    mir_queue_pop(queue, (void**)&(*task));
-    if (!*task) {
+    return pushed;
+} /*}}}*/
+
+static inline int take_central(struct mir_worker_t* worker, struct mir_queue_t* queue, struct mir_task_t* task)
+{ /*{{{*/
+    if (!task) {
         return 0;
     }
 
     if (runtime->enable_task_stats == 1)
-        (*task)->queue_size_at_pop = mir_queue_size(queue);
+        task->queue_size_at_pop = mir_queue_size(queue);
     // Update stats
     if (runtime->enable_worker_stats == 1) {
         worker->statistics->num_tasks_owned++;
 #ifdef MIR_MEM_POL_ENABLE
         uint16_t node = runtime->arch->node_of(worker->cpu_id);
-        struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(*task, MIR_DATA_ACCESS_READ);
+        struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(task, MIR_DATA_ACCESS_READ);
         if (dist) {
-            (*task)->comm_cost = mir_mem_node_dist_get_comm_cost(dist, node);
-            mir_worker_statistics_update_comm_cost(worker->statistics, (*task)->comm_cost);
+            task->comm_cost = mir_mem_node_dist_get_comm_cost(dist, node);
+            mir_worker_statistics_update_comm_cost(worker->statistics, task->comm_cost);
         }
 #endif
     }
 
     __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
-    T_DBG("Dq", *task);
+    T_DBG("Dq", task);
 
     return 1;
 } /*}}}*/
 
+int pop_central(struct mir_task_t** task)
+{ /*{{{*/
+    //MIR_RECORDER_STATE_BEGIN(MIR_STATE_TMOBING);
+
+    struct mir_sched_pol_t* sp = runtime->sched_pol;
+    MIR_ASSERT(NULL != sp);
+    struct mir_queue_t* queue = sp->queues[0];
+    MIR_ASSERT(NULL != queue);
+    if (mir_queue_size(queue) == 0) {
+        return 0;
+    }
+
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT(NULL != worker);
+
+    *task = NULL;
+    mir_queue_pop(queue, (void**)&(*task));
+
+    return take_central(worker, queue, *task);
+} /*}}}*/
+
+int pop_from_central(struct mir_worker_t* worker, uint16_t victim, struct mir_task_t* ancestor, struct mir_task_t** task)
+{ /*{{{*/
+    MIR_ASSERT(NULL != worker);
+    MIR_ASSERT(NULL != ancestor);
+
+    // The queue is shared
+    if (victim != worker->id)
+        return 0;
+
+    struct mir_queue_t* queue = runtime->sched_pol->queues[0];
+    MIR_ASSERT(NULL != queue);
+    if (mir_queue_size(queue) == 0)
+        return 0;
+
+    *task = mir_task_queue_pop_descendant((struct mir_task_queue_t*)queue, ancestor);
+
+    return take_central(worker, queue, *task);
+} /*}}}*/
+
 struct mir_sched_pol_t policy_central = { /*{{{*/
     .num_queues = 1,
     .queue_capacity = MIR_QUEUE_MAX_CAPACITY,
@@ -129,6 +175,8 @@ struct mir_sched_pol_t policy_central = { /*{{{*/
     .create = create_central,
     .destroy = destroy_central,
     .push = push_central,
-    .pop = pop_central
+    .push_many = push_many_central,
+    .pop = pop_central,
+    .pop_from = pop_from_central
 }; /*}}}*/
 
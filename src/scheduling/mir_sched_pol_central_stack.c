@@ -76,47 +76,94 @@ int push_central_stack(struct mir_worker_t* worker, struct mir_task_t* task)
     return pushed;
 } /*}}}*/
 
-int pop_central_stack(struct mir_task_t** task)
+int push_many_central_stack(struct mir_worker_t* worker, struct mir_task_t** tasks, unsigned int num_tasks)
 { /*{{{*/
-    struct mir_sched_pol_t* sp = runtime->sched_pol;
-    MIR_ASSERT(NULL != sp);
-    struct mir_task_stack_t* queue = (struct mir_task_stack_t*)(sp->queues[0]);
-    MIR_ASSERT(NULL != queue);
-    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT(NULL != tasks);
     MIR_ASSERT(NULL != worker);
 
-    if (mir_task_stack_size(queue) == 0) {
-        return 0;
-    }
+    // Push tasks to central_stack queue in one go
+    struct mir_task_stack_t* queue = (struct mir_task_stack_t*)(runtime->sched_pol->queues[0]);
+    MIR_ASSERT(NULL != queue);
+    unsigned int pushed = mir_task_stack_push_many(queue, tasks, num_tasks);
+    __sync_fetch_and_add(&g_num_tasks_waiting, pushed);
+    // Update stats
+    if (runtime->enable_worker_stats == 1)
+        worker->statistics->num_tasks_created += pushed;
 
-    *task = NULL;
-    mir_task_stack_pop(queue, &(*task));
-    if (!*task) {
+    // Tasks that did not fit take the single push path
+    for (unsigned int i = pushed; i < num_tasks; i++)
+        pushed += push_central_stack(worker, tasks[i]);
+
+    return pushed;
+} /*}}}*/
+
+static inline int take_central_stack(struct mir_worker_t* worker, struct mir_task_stack_t* queue, struct mir_task_t* task)
+{ /*{{{*/
+    if (!task) {
         return 0;
     }
 
     if (runtime->enable_task_stats == 1)
-        (*task)->queue_size_at_pop = mir_task_stack_size(queue);
+        task->queue_size_at_pop = mir_task_stack_size(queue);
 
     // Update stats
     if (runtime->enable_worker_stats == 1) {
 #ifdef MIR_MEM_POL_ENABLE
         uint16_t node = runtime->arch->node_of(worker->cpu_id);
-        struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(*task, MIR_DATA_ACCESS_READ);
+        struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(task, MIR_DATA_ACCESS_READ);
         if (dist) {
-            (*task)->comm_cost = mir_mem_node_dist_get_comm_cost(dist, node);
-            mir_worker_statistics_update_comm_cost(worker->statistics, (*task)->comm_cost);
+            task->comm_cost = mir_mem_node_dist_get_comm_cost(dist, node);
+            mir_worker_statistics_update_comm_cost(worker->statistics, task->comm_cost);
         }
 #endif
         worker->statistics->num_tasks_owned++;
     }
 
     __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
-    T_DBG("Dq", *task);
+    T_DBG("Dq", task);
 
     return 1;
 } /*}}}*/
 
+int pop_central_stack(struct mir_task_t** task)
+{ /*{{{*/
+    struct mir_sched_pol_t* sp = runtime->sched_pol;
+    MIR_ASSERT(NULL != sp);
+    struct mir_task_stack_t* queue = (struct mir_task_stack_t*)(sp->queues[0]);
+    MIR_ASSERT(NULL != queue);
+    struct mir_worker_t* worker = mir_worker_get_context();
+    MIR_ASSERT(NULL != worker);
+
+    if (mir_task_stack_size(queue) == 0) {
+        return 0;
+    }
+
+    *task = NULL;
+    mir_task_stack_pop(queue, &(*task));
+
+    return take_central_stack(worker, queue, *task);
+} /*}}}*/
+
+int pop_from_central_stack(struct mir_worker_t* worker, uint16_t victim, struct mir_task_t* ancestor, struct mir_task_t** task)
+{ /*{{{*/
+    MIR_ASSERT(NULL != worker);
+    MIR_ASSERT(NULL != ancestor);
+
+    // The stack is shared
+    if (victim != worker->id)
+        return 0;
+
+    struct mir_task_stack_t* queue = (struct mir_task_stack_t*)(runtime->sched_pol->queues[0]);
+    MIR_ASSERT(NULL != queue);
+    if (mir_task_stack_size(queue) == 0)
+        return 0;
+
+    *task = NULL;
+    mir_task_stack_pop_descendant(queue, ancestor, &(*task));
+
+    return take_central_stack(worker, queue, *task);
+} /*}}}*/
+
 struct mir_sched_pol_t policy_central_stack = { /*{{{*/
     .num_queues = 1,
     .queue_capacity = MIR_QUEUE_MAX_CAPACITY,
@@ -126,6 +173,8 @@ struct mir_sched_pol_t policy_central_stack = { /*{{{*/
     .create = create_central_stack,
     .destroy = destroy_central_stack,
     .push = push_central_stack,
-    .pop = pop_central_stack
+    .push_many = push_many_central_stack,
+    .pop = pop_central_stack,
+    .pop_from = pop_from_central_stack
 }; /*}}}*/
 
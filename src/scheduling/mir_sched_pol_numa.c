@@ -103,9 +103,16 @@ int push_numa(struct mir_worker_t* this_worker, struct mir_task_t* task)
 
     // Push task onto node with the least access cost to read data footprint
     // If no data footprint, push task onto this worker's node
-    struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(task, MIR_DATA_ACCESS_READ);
+    // Affinity hints override both
+    struct mir_mem_node_dist_t* dist = NULL;
+    if (task->affinity_node < 0)
+        dist = mir_task_get_mem_node_dist(task, MIR_DATA_ACCESS_READ);
     //struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(task, MIR_DATA_ACCESS_WRITE);
-    if (dist) {
+    if (task->affinity_node >= 0) {
+        int target = mir_sched_pol_affinity_target(this_worker, task);
+        least_cost_worker = target >= 0 ? &runtime->workers[target] : this_worker;
+    }
+    else if (dist) {
         if (is_data_dist_significant(dist) == 0) {
             /*MIR_LOG_INFO("Task %" MIR_FORMSPEC_UL " ignored.", task->id.uid);*/
             least_cost_worker = this_worker;
@@ -343,6 +350,50 @@ int pop_numa(struct mir_task_t** task)
     return found;
 } /*}}}*/
 
+int pop_from_numa(struct mir_worker_t* worker, uint16_t victim, struct mir_task_t* ancestor, struct mir_task_t** task)
+{ /*{{{*/
+    MIR_ASSERT(NULL != worker);
+    MIR_ASSERT(NULL != ancestor);
+    struct mir_sched_pol_t* sp = runtime->sched_pol;
+    MIR_ASSERT(NULL != sp);
+    uint16_t node = runtime->arch->node_of(worker->cpu_id);
+    uint16_t victim_node = runtime->arch->node_of(runtime->workers[victim].cpu_id);
+
+    // Queues are per node. Tasks without significant data come first, as in pop_numa().
+    *task = NULL;
+    struct mir_task_queue_t* queue = (struct mir_task_queue_t*)sp->alt_queues[victim_node];
+    if (mir_task_queue_size(queue) > 0)
+        *task = mir_task_queue_pop_descendant(queue, ancestor);
+    queue = (struct mir_task_queue_t*)sp->queues[victim_node];
+    if (*task == NULL && mir_task_queue_size(queue) > 0)
+        *task = mir_task_queue_pop_descendant(queue, ancestor);
+    if (*task == NULL)
+        return 0;
+
+    // Update stats
+    if (runtime->enable_worker_stats == 1) {
+        if (victim_node == node) {
+            // task->comm-cost already calculated in push
+            if ((*task)->comm_cost != -1)
+                mir_worker_statistics_update_comm_cost(worker->statistics, (*task)->comm_cost);
+            worker->statistics->num_tasks_owned++;
+        }
+        else {
+            struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(*task, MIR_DATA_ACCESS_READ);
+            if (dist) {
+                (*task)->comm_cost = mir_mem_node_dist_get_comm_cost(dist, node);
+                mir_worker_statistics_update_comm_cost(worker->statistics, (*task)->comm_cost);
+            }
+            worker->statistics->num_tasks_stolen++;
+        }
+    }
+
+    __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
+    T_DBG(victim_node == node ? "Dq" : "St", *task);
+
+    return 1;
+} /*}}}*/
+
 struct mir_sched_pol_t policy_numa = { /*{{{*/
     .num_queues = MIR_WORKER_MAX_COUNT,
     .queue_capacity = MIR_QUEUE_MAX_CAPACITY,
@@ -352,7 +403,8 @@ struct mir_sched_pol_t policy_numa = { /*{{{*/
     .create = create_numa,
     .destroy = destroy_numa,
     .push = push_numa,
-    .pop = pop_numa
+    .pop = pop_numa,
+    .pop_from = pop_from_numa
 }; /*}}}*/
 #endif
 
@@ -79,6 +79,54 @@ int push_ws(struct mir_worker_t* worker, struct mir_task_t* task)
     return pushed;
 } /*}}}*/
 
+int push_many_ws(struct mir_worker_t* worker, struct mir_task_t** tasks, unsigned int num_tasks)
+{ /*{{{*/
+    MIR_ASSERT(NULL != tasks);
+    MIR_ASSERT(NULL != worker);
+
+    // Push tasks to this workers queue in one go
+    struct mir_queue_t* queue = runtime->sched_pol->queues[worker->id];
+    MIR_ASSERT(NULL != queue);
+    unsigned int pushed = mir_queue_push_many(queue, (void**)tasks, num_tasks);
+    __sync_fetch_and_add(&g_num_tasks_waiting, pushed);
+    // Update stats
+    if (runtime->enable_worker_stats == 1)
+        worker->statistics->num_tasks_created += pushed;
+
+    // Tasks that did not fit take the single push path
+    for (unsigned int i = pushed; i < num_tasks; i++)
+        pushed += push_ws(worker, tasks[i]);
+
+    return pushed;
+} /*}}}*/
+
+static inline int take_ws(struct mir_worker_t* worker, uint16_t ctr, struct mir_task_t* task)
+{ /*{{{*/
+    if (!task)
+        return 0;
+
+    // Update stats
+    if (runtime->enable_worker_stats == 1) {
+#ifdef MIR_MEM_POL_ENABLE
+        uint16_t node = runtime->arch->node_of(worker->cpu_id);
+        struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(task, MIR_DATA_ACCESS_READ);
+        if (dist) {
+            task->comm_cost = mir_mem_node_dist_get_comm_cost(dist, node);
+            mir_worker_statistics_update_comm_cost(worker->statistics, task->comm_cost);
+        }
+#endif
+        if (ctr == worker->id)
+            worker->statistics->num_tasks_owned++;
+        else
+            worker->statistics->num_tasks_stolen++;
+    }
+
+    __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
+    T_DBG(ctr == worker->id ? "Dq" : "St", task);
+
+    return 1;
+} /*}}}*/
+
 int pop_ws(struct mir_task_t** task)
 { /*{{{*/
     struct mir_sched_pol_t* sp = runtime->sched_pol;
@@ -106,33 +154,28 @@ int pop_ws(struct mir_task_t** task)
 
         *task = NULL;
         mir_queue_pop(queue, (void**)&(*task));
-        if (*task) {
-            // Update stats
-            if (runtime->enable_worker_stats == 1) {
-#ifdef MIR_MEM_POL_ENABLE
-                uint16_t node = runtime->arch->node_of(worker->cpu_id);
-                struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(*task, MIR_DATA_ACCESS_READ);
-                if (dist) {
-                    (*task)->comm_cost = mir_mem_node_dist_get_comm_cost(dist, node);
-                    mir_worker_statistics_update_comm_cost(worker->statistics, (*task)->comm_cost);
-                }
-#endif
-                if (ctr == worker->id)
-                    worker->statistics->num_tasks_owned++;
-                else
-                    worker->statistics->num_tasks_stolen++;
-            }
-
-            __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
-            T_DBG(ctr == worker->id ? "Dq" : "St", *task);
-
+        if (1 == take_ws(worker, ctr, *task))
             return 1;
-        }
     } while (++ctr != worker->id);
 
     return 0;
 } /*}}}*/
 
+int pop_from_ws(struct mir_worker_t* worker, uint16_t victim, struct mir_task_t* ancestor, struct mir_task_t** task)
+{ /*{{{*/
+    MIR_ASSERT(NULL != worker);
+    MIR_ASSERT(NULL != ancestor);
+
+    struct mir_queue_t* queue = runtime->sched_pol->queues[victim];
+    MIR_ASSERT(NULL != queue);
+    if (mir_queue_size(queue) == 0)
+        return 0;
+
+    *task = mir_task_queue_pop_descendant((struct mir_task_queue_t*)queue, ancestor);
+
+    return take_ws(worker, victim, *task);
+} /*}}}*/
+
 struct mir_sched_pol_t policy_ws = { /*{{{*/
     .num_queues = MIR_WORKER_MAX_COUNT,
     .queue_capacity = MIR_QUEUE_MAX_CAPACITY,
@@ -142,6 +185,8 @@ struct mir_sched_pol_t policy_ws = { /*{{{*/
     .create = create_ws,
     .destroy = destroy_ws,
     .push = push_ws,
-    .pop = pop_ws
+    .push_many = push_many_ws,
+    .pop = pop_ws,
+    .pop_from = pop_from_ws
 }; /*}}}*/
 
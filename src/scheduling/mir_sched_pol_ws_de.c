@@ -29,6 +29,9 @@ void create_ws_de()
         sp->queues[i] = (struct mir_queue_t*)newWSDeque(sp->queue_capacity);
         MIR_ASSERT(NULL != sp->queues[i]);
     }
+
+    // Create affinity mailboxes
+    mir_sched_pol_create_mailboxes();
 } /*}}}*/
 
 void destroy_ws_de()
@@ -47,6 +50,9 @@ void destroy_ws_de()
     MIR_ASSERT(NULL != sp->queues);
     mir_free_int(sp->queues, sizeof(mir_dequeue_t*) * sp->num_queues);
     sp->queues = NULL;
+
+    // Free affinity mailboxes
+    mir_sched_pol_destroy_mailboxes();
 } /*}}}*/
 
 int push_ws_de(struct mir_worker_t* worker, struct mir_task_t* task)
@@ -56,6 +62,11 @@ int push_ws_de(struct mir_worker_t* worker, struct mir_task_t* task)
 
     int pushed = 1;
 
+    // Hinted tasks go to the mailbox of their worker
+    int target = mir_sched_pol_affinity_target(worker, task);
+    if (target >= 0 && 1 == mir_sched_pol_push_mailbox(worker, task, target))
+        return pushed;
+
     // ws has per-worker queues
     mir_dequeue_t* queue = (mir_dequeue_t*)runtime->sched_pol->queues[worker->id];
     MIR_ASSERT(NULL != queue);
@@ -82,6 +93,55 @@ int push_ws_de(struct mir_worker_t* worker, struct mir_task_t* task)
     return pushed;
 } /*}}}*/
 
+int push_many_ws_de(struct mir_worker_t* worker, struct mir_task_t** tasks, unsigned int num_tasks)
+{ /*{{{*/
+    MIR_ASSERT(NULL != tasks);
+    MIR_ASSERT(NULL != worker);
+
+    // Push tasks to this workers deque with a single bottom update
+    mir_dequeue_t* queue = (mir_dequeue_t*)runtime->sched_pol->queues[worker->id];
+    MIR_ASSERT(NULL != queue);
+    unsigned int pushed = pushManyWSDeque(queue, (void**)tasks, num_tasks);
+    __sync_fetch_and_add(&g_num_tasks_waiting, pushed);
+    // Update stats
+    if (runtime->enable_worker_stats == 1)
+        worker->statistics->num_tasks_created += pushed;
+
+    // Tasks that did not fit take the single push path
+    for (unsigned int i = pushed; i < num_tasks; i++)
+        pushed += push_ws_de(worker, tasks[i]);
+
+    return pushed;
+} /*}}}*/
+
+static inline int take_ws_de(struct mir_worker_t* worker, uint16_t ctr, struct mir_task_t* task)
+{ /*{{{*/
+    if (!__sync_bool_compare_and_swap(&(task->taken), 0, 1))
+        return 0;
+
+    // Update stats
+    if (runtime->enable_worker_stats == 1) {
+#ifdef MIR_MEM_POL_ENABLE
+        uint16_t node = runtime->arch->node_of(worker->cpu_id);
+        struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(task, MIR_DATA_ACCESS_READ);
+        if (dist) {
+            task->comm_cost = mir_mem_node_dist_get_comm_cost(dist, node);
+            mir_worker_statistics_update_comm_cost(worker->statistics, task->comm_cost);
+        }
+#endif
+        if (ctr == worker->id)
+            worker->statistics->num_tasks_owned++;
+        else
+            worker->statistics->num_tasks_stolen++;
+    }
+
+    __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
+    MIR_ASSERT(g_num_tasks_waiting >= 0);
+    T_DBG(ctr == worker->id ? "Dq" : "St", task);
+
+    return 1;
+} /*}}}*/
+
 int pop_ws_de(struct mir_task_t** task)
 { /*{{{*/
     struct mir_sched_pol_t* sp = runtime->sched_pol;
@@ -90,15 +150,18 @@ int pop_ws_de(struct mir_task_t** task)
     struct mir_worker_t* worker = mir_worker_get_context();
     MIR_ASSERT(NULL != worker);
 
+    // Tasks hinted to this worker come first
+    if (mir_sched_pol_pop_mailbox(worker, worker->id, task))
+        return 1;
+
     // Start with own queue, round-robin if empty.
     uint16_t ctr = worker->id;
     do {
         // Wrap around.
         if (ctr == num_queues) {
 	    // Worker 0 has already tried all queues, bail out.
-            if (worker->id == 0) {
-                return 0;
-            }
+            if (worker->id == 0)
+                break;
             ctr = 0;
         }
 
@@ -107,36 +170,56 @@ int pop_ws_de(struct mir_task_t** task)
             continue;
 
         *task = ctr == worker->id ? (struct mir_task_t*)popWSDeque(queue) : (struct mir_task_t*)stealWSDeque(queue);
-        if (*task) {
-            if (__sync_bool_compare_and_swap(&((*task)->taken), 0, 1)) {
-                // Update stats
-                if (runtime->enable_worker_stats == 1) {
-#ifdef MIR_MEM_POL_ENABLE
-                    uint16_t node = runtime->arch->node_of(worker->cpu_id);
-                    struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(*task, MIR_DATA_ACCESS_READ);
-                    if (dist) {
-                        (*task)->comm_cost = mir_mem_node_dist_get_comm_cost(dist, node);
-                        mir_worker_statistics_update_comm_cost(worker->statistics, (*task)->comm_cost);
-                    }
-#endif
-                    if (ctr == worker->id)
-                        worker->statistics->num_tasks_owned++;
-                    else
-                        worker->statistics->num_tasks_stolen++;
-                }
-
-                __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
-                MIR_ASSERT(g_num_tasks_waiting >= 0);
-                T_DBG(ctr == worker->id ? : "Dq" : "St", *task);
-
-                return 1;
-            }
-        }
+        if (*task && 1 == take_ws_de(worker, ctr, *task))
+            return 1;
     } while (++ctr != worker->id);
 
+    // Fall back to stealing hinted tasks
+    for (int i = 1; i < runtime->num_workers; i++)
+        if (mir_sched_pol_pop_mailbox(worker, (worker->id + i) % runtime->num_workers, task))
+            return 1;
+
     return 0;
 } /*}}}*/
 
+int pop_from_ws_de(struct mir_worker_t* worker, uint16_t victim, struct mir_task_t* ancestor, struct mir_task_t** task)
+{ /*{{{*/
+    MIR_ASSERT(NULL != worker);
+    MIR_ASSERT(NULL != ancestor);
+
+    // Tasks hinted to the victim come first
+    if (1 == mir_sched_pol_pop_mailbox_descendant(worker, victim, ancestor, task))
+        return 1;
+
+    mir_dequeue_t* queue = (mir_dequeue_t*)runtime->sched_pol->queues[victim];
+    MIR_ASSERT(NULL != queue);
+    if (looksEmptyWSDeque(queue) == rtsTrue)
+        return 0;
+
+    // Look at the end we would take from. The owner takes the newest task,
+    // ... thieves the oldest.
+    int own = victim == worker->id;
+    struct mir_task_t* next = own ? queue->elements[(queue->bottom - 1) & queue->moduloSize] : queue->elements[queue->top & queue->moduloSize];
+    if (next == NULL || 0 == mir_task_descends_from(next, ancestor))
+        return 0;
+
+    struct mir_task_t* t = own ? (struct mir_task_t*)popWSDeque(queue) : (struct mir_task_t*)stealWSDeque(queue);
+    if (t == NULL)
+        return 0;
+
+    // Another thief got there first and we stole an unrelated task
+    // Keep it waiting in our own deque
+    if (!own && 0 == mir_task_descends_from(t, ancestor) &&
+        rtsTrue == pushWSDeque((mir_dequeue_t*)runtime->sched_pol->queues[worker->id], (void*)t))
+        return 0;
+
+    if (0 == take_ws_de(worker, victim, t))
+        return 0;
+
+    *task = t;
+    return 1;
+} /*}}}*/
+
 struct mir_sched_pol_t policy_ws_de = { /*{{{*/
     .num_queues = MIR_WORKER_MAX_COUNT,
     .queue_capacity = MIR_QUEUE_MAX_CAPACITY,
@@ -146,6 +229,8 @@ struct mir_sched_pol_t policy_ws_de = { /*{{{*/
     .create = create_ws_de,
     .destroy = destroy_ws_de,
     .push = push_ws_de,
-    .pop = pop_ws_de
+    .push_many = push_many_ws_de,
+    .pop = pop_ws_de,
+    .pop_from = pop_from_ws_de
 }; /*}}}*/
 
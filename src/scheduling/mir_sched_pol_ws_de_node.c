@@ -29,6 +29,9 @@ void create_ws_de_node()
         sp->queues[i] = (struct mir_queue_t*)newWSDeque(sp->queue_capacity);
         MIR_ASSERT(NULL != sp->queues[i]);
     }
+
+    // Create affinity mailboxes
+    mir_sched_pol_create_mailboxes();
 } /*}}}*/
 
 void destroy_ws_de_node()
@@ -47,6 +50,9 @@ void destroy_ws_de_node()
     MIR_ASSERT(NULL != sp->queues);
     mir_free_int(sp->queues, sizeof(mir_dequeue_t*) * sp->num_queues);
     sp->queues = NULL;
+
+    // Free affinity mailboxes
+    mir_sched_pol_destroy_mailboxes();
 } /*}}}*/
 
 int push_ws_de_node(struct mir_worker_t* worker, struct mir_task_t* task)
@@ -56,6 +62,11 @@ int push_ws_de_node(struct mir_worker_t* worker, struct mir_task_t* task)
 
     int pushed = 1;
 
+    // Hinted tasks go to the mailbox of their worker
+    int target = mir_sched_pol_affinity_target(worker, task);
+    if (target >= 0 && 1 == mir_sched_pol_push_mailbox(worker, task, target))
+        return pushed;
+
     // ws has per-worker queues
     mir_dequeue_t* queue = (mir_dequeue_t*)runtime->sched_pol->queues[worker->id];
     MIR_ASSERT(NULL != queue);
@@ -91,6 +102,10 @@ int pop_ws_de_node(struct mir_task_t** task)
     MIR_ASSERT(NULL != worker);
     uint16_t node = runtime->arch->node_of(worker->cpu_id);
 
+    // Tasks hinted to this worker come first
+    if (mir_sched_pol_pop_mailbox(worker, worker->id, task))
+        return 1;
+
     // Start with own queue, round-robin within own node if empty.
     uint16_t ctr = worker->id;
     do {
@@ -181,9 +196,76 @@ int pop_ws_de_node(struct mir_task_t** task)
         }
     } /*}}}*/
 
+    // Fall back to stealing hinted tasks, nearest workers first
+    for (int i = 1; i < runtime->num_workers; i++) {
+        uint16_t from = (worker->id + i) % runtime->num_workers;
+        if (node == runtime->arch->node_of(runtime->workers[from].cpu_id) && mir_sched_pol_pop_mailbox(worker, from, task))
+            return 1;
+    }
+    for (int i = 1; i < runtime->num_workers; i++)
+        if (mir_sched_pol_pop_mailbox(worker, (worker->id + i) % runtime->num_workers, task))
+            return 1;
+
     return 0;
 } /*}}}*/
 
+int pop_from_ws_de_node(struct mir_worker_t* worker, uint16_t victim, struct mir_task_t* ancestor, struct mir_task_t** task)
+{ /*{{{*/
+    MIR_ASSERT(NULL != worker);
+    MIR_ASSERT(NULL != ancestor);
+
+    // Tasks hinted to the victim come first
+    if (1 == mir_sched_pol_pop_mailbox_descendant(worker, victim, ancestor, task))
+        return 1;
+
+    mir_dequeue_t* queue = (mir_dequeue_t*)runtime->sched_pol->queues[victim];
+    MIR_ASSERT(NULL != queue);
+    if (looksEmptyWSDeque(queue) == rtsTrue)
+        return 0;
+
+    // Look at the end we would take from. The owner takes the newest task,
+    // ... thieves the oldest.
+    int own = victim == worker->id;
+    struct mir_task_t* next = own ? queue->elements[(queue->bottom - 1) & queue->moduloSize] : queue->elements[queue->top & queue->moduloSize];
+    if (next == NULL || 0 == mir_task_descends_from(next, ancestor))
+        return 0;
+
+    struct mir_task_t* t = own ? (struct mir_task_t*)popWSDeque(queue) : (struct mir_task_t*)stealWSDeque(queue);
+    if (t == NULL)
+        return 0;
+
+    // Another thief got there first and we stole an unrelated task
+    // Keep it waiting in our own deque
+    if (!own && 0 == mir_task_descends_from(t, ancestor) &&
+        rtsTrue == pushWSDeque((mir_dequeue_t*)runtime->sched_pol->queues[worker->id], (void*)t))
+        return 0;
+
+    if (!__sync_bool_compare_and_swap(&(t->taken), 0, 1))
+        return 0;
+
+    // Update stats
+    if (runtime->enable_worker_stats == 1) {
+#ifdef MIR_MEM_POL_ENABLE
+        struct mir_mem_node_dist_t* dist = mir_task_get_mem_node_dist(t, MIR_DATA_ACCESS_READ);
+        if (dist) {
+            t->comm_cost = mir_mem_node_dist_get_comm_cost(dist, runtime->arch->node_of(worker->cpu_id));
+            mir_worker_statistics_update_comm_cost(worker->statistics, t->comm_cost);
+        }
+#endif
+        if (own)
+            worker->statistics->num_tasks_owned++;
+        else
+            worker->statistics->num_tasks_stolen++;
+    }
+
+    __sync_fetch_and_sub(&g_num_tasks_waiting, 1);
+    MIR_ASSERT(g_num_tasks_waiting >= 0);
+    T_DBG(own ? "Dq" : "St", t);
+
+    *task = t;
+    return 1;
+} /*}}}*/
+
 struct mir_sched_pol_t policy_ws_de_node = { /*{{{*/
     .num_queues = MIR_WORKER_MAX_COUNT,
     .queue_capacity = MIR_QUEUE_MAX_CAPACITY,
@@ -193,6 +275,7 @@ struct mir_sched_pol_t policy_ws_de_node = { /*{{{*/
     .create = create_ws_de_node,
     .destroy = destroy_ws_de_node,
     .push = push_ws_de_node,
-    .pop = pop_ws_de_node
+    .pop = pop_ws_de_node,
+    .pop_from = pop_from_ws_de_node
 }; /*}}}*/
 
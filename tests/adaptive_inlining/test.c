@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+static uint64_t fib(int n);
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    uint64_t* x_0;
+    int n_0;
+} data_env_0_t; /*}}}*/
+
+void ol_fib_0(data_env_0_t* arg)
+{ /*{{{*/
+    *(arg->x_0) = fib(arg->n_0);
+} /*}}}*/
+
+// No manual cutoff
+// Leaf tasks are small enough to be inlined by the runtime system
+uint64_t fib(int n)
+{ /*{{{*/
+    uint64_t x, y;
+    if (n < 2)
+        return n;
+
+    data_env_0_t imm_args_0;
+    imm_args_0.x_0 = &(x);
+    imm_args_0.n_0 = n - 1;
+    mir_task_create((mir_tfunc_t)ol_fib_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_fib_0");
+
+    data_env_0_t imm_args_1;
+    imm_args_1.x_0 = &(y);
+    imm_args_1.n_0 = n - 2;
+    mir_task_create((mir_tfunc_t)ol_fib_0, (void*)&imm_args_1, sizeof(data_env_0_t), 0, NULL, "ol_fib_0");
+
+    mir_task_wait();
+
+    return x + y;
+} /*}}}*/
+
+START_TEST(adaptive_inlining)
+{/*{{{*/
+    mir_create();
+
+    // Run twice so the second run benefits from measurements of the first
+    for (int i = 0; i < 2; i++) {
+        uint64_t result = fib(20);
+        ck_assert_int_eq(result, 6765);
+    }
+
+    mir_destroy();
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("adaptive_inlining");
+    tcase_add_test(tc, adaptive_inlining);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define NUM_LEAVES 64
+#define CHAIN_LENGTH 100
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    long value_0;
+} data_env_0_t; /*}}}*/
+
+typedef struct data_env_1_t_tag { /*{{{*/
+    struct mir_future_t* in_1[2];
+} data_env_1_t; /*}}}*/
+
+typedef struct data_env_2_t_tag { /*{{{*/
+    struct mir_future_t* in_2;
+} data_env_2_t; /*}}}*/
+
+void* ol_leaf_0(data_env_0_t* arg)
+{ /*{{{*/
+    mir_sleep_us(10);
+    return (void*)arg->value_0;
+} /*}}}*/
+
+void* ol_add_1(data_env_1_t* arg)
+{ /*{{{*/
+    // Predecessors are done
+    ck_assert_int_eq(mir_future_done(arg->in_1[0]), 1);
+    long sum = (long)mir_future_get(arg->in_1[0]) + (long)mir_future_get(arg->in_1[1]);
+    mir_future_destroy(arg->in_1[0]);
+    mir_future_destroy(arg->in_1[1]);
+    return (void*)sum;
+} /*}}}*/
+
+void* ol_incr_2(data_env_2_t* arg)
+{ /*{{{*/
+    long value = (long)mir_future_get(arg->in_2) + 1;
+    mir_future_destroy(arg->in_2);
+    return (void*)value;
+} /*}}}*/
+
+START_TEST(continuation_chain)
+{/*{{{*/
+    mir_create();
+
+    data_env_0_t imm_args_0;
+    imm_args_0.value_0 = 0;
+    struct mir_future_t* f = mir_task_create_future((mir_tfunc_t)ol_leaf_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_leaf_0");
+
+    // No task waits in between
+    for (int i = 0; i < CHAIN_LENGTH; i++) {
+        data_env_2_t imm_args_2;
+        imm_args_2.in_2 = f;
+        f = mir_task_then(f, (mir_tfunc_t)ol_incr_2, (void*)&imm_args_2, sizeof(data_env_2_t), "ol_incr_2");
+    }
+
+    long result = (long)mir_future_get(f);
+    mir_future_destroy(f);
+
+    mir_task_wait();
+
+    mir_destroy();
+
+    ck_assert_int_eq(result, CHAIN_LENGTH);
+}/*}}}*/
+END_TEST
+
+START_TEST(continuation_reduction_tree)
+{/*{{{*/
+    mir_create();
+
+    struct mir_future_t* level[NUM_LEAVES];
+    for (int i = 0; i < NUM_LEAVES; i++) {
+        data_env_0_t imm_args_0;
+        imm_args_0.value_0 = i + 1;
+        level[i] = mir_task_create_future((mir_tfunc_t)ol_leaf_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_leaf_0");
+    }
+
+    // Pairwise sums run as soon as both inputs are ready
+    for (int n = NUM_LEAVES; n > 1; n /= 2) {
+        for (int i = 0; i < n / 2; i++) {
+            data_env_1_t imm_args_1;
+            imm_args_1.in_1[0] = level[2 * i];
+            imm_args_1.in_1[1] = level[2 * i + 1];
+            level[i] = mir_task_when_all(imm_args_1.in_1, 2, (mir_tfunc_t)ol_add_1, (void*)&imm_args_1, sizeof(data_env_1_t), "ol_add_1");
+        }
+    }
+
+    long result = (long)mir_future_get(level[0]);
+    mir_future_destroy(level[0]);
+
+    mir_task_wait();
+
+    mir_destroy();
+
+    ck_assert_int_eq(result, NUM_LEAVES * (NUM_LEAVES + 1) / 2);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("continuation");
+    tcase_add_test(tc, continuation_chain);
+    tcase_add_test(tc, continuation_reduction_tree);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
@@ -0,0 +1,113 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "mir_public_int.h"
+
+#define NUM_THREADS 2
+#define NUM_TASKS 64
+
+static uint64_t fib_seq(int n)
+{ /*{{{*/
+    if (n < 2)
+        return n;
+    return fib_seq(n - 1) + fib_seq(n - 2);
+} /*}}}*/
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    uint64_t* res_0;
+    int n_0;
+} data_env_0_t; /*}}}*/
+
+void ol_fib_0(data_env_0_t* arg)
+{ /*{{{*/
+    (*arg->res_0) = fib_seq(arg->n_0);
+} /*}}}*/
+
+struct submitter_t { /*{{{*/
+    pthread_t thread;
+    uint64_t results[NUM_TASKS];
+    struct mir_task_handle_t* handles[NUM_TASKS];
+    volatile int num_submitted;
+}; /*}}}*/
+
+static void* submitter(void* arg)
+{ /*{{{*/
+    struct submitter_t* s = (struct submitter_t*)arg;
+
+    for (int i = 0; i < NUM_TASKS; i++) {
+        data_env_0_t imm_args_0;
+        imm_args_0.res_0 = &(s->results[i]);
+        imm_args_0.n_0 = 20;
+        s->handles[i] = mir_task_submit((mir_tfunc_t)ol_fib_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_fib_0");
+        __sync_synchronize();
+        s->num_submitted = i + 1;
+    }
+
+    // Block on handles
+    for (int i = 0; i < NUM_TASKS; i++)
+        mir_task_handle_wait(s->handles[i]);
+
+    return NULL;
+} /*}}}*/
+
+START_TEST(ext_submit)
+{/*{{{*/
+    struct submitter_t submitters[NUM_THREADS];
+
+    mir_create();
+
+    for (int t = 0; t < NUM_THREADS; t++) {
+        submitters[t].num_submitted = 0;
+        pthread_create(&submitters[t].thread, NULL, submitter, &submitters[t]);
+    }
+
+    // Help execute submitted tasks
+    for (int t = 0; t < NUM_THREADS; t++) {
+        for (int i = 0; i < NUM_TASKS; i++) {
+            while (submitters[t].num_submitted <= i)
+                __sync_synchronize();
+            mir_task_handle_wait(submitters[t].handles[i]);
+        }
+    }
+
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_join(submitters[t].thread, NULL);
+        for (int i = 0; i < NUM_TASKS; i++) {
+            ck_assert(mir_task_handle_test(submitters[t].handles[i]) == 1);
+            mir_task_handle_destroy(submitters[t].handles[i]);
+            ck_assert_int_eq(submitters[t].results[i], 6765); // fib(20) = 6765
+        }
+    }
+
+    mir_destroy();
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("ext_submit");
+    tcase_add_test(tc, ext_submit);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
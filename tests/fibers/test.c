@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define CHAIN_LENGTH 200
+
+static uint64_t fib(int n);
+static uint64_t chain(int n);
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    uint64_t* x_0;
+    int n_0;
+} data_env_0_t; /*}}}*/
+
+void ol_fib_0(data_env_0_t* arg)
+{ /*{{{*/
+    *(arg->x_0) = fib(arg->n_0);
+} /*}}}*/
+
+void ol_chain_0(data_env_0_t* arg)
+{ /*{{{*/
+    *(arg->x_0) = chain(arg->n_0);
+} /*}}}*/
+
+uint64_t fib(int n)
+{ /*{{{*/
+    uint64_t x, y;
+    if (n < 2)
+        return n;
+
+    data_env_0_t imm_args_0;
+    imm_args_0.x_0 = &(x);
+    imm_args_0.n_0 = n - 1;
+    mir_task_create((mir_tfunc_t)ol_fib_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_fib_0");
+
+    data_env_0_t imm_args_1;
+    imm_args_1.x_0 = &(y);
+    imm_args_1.n_0 = n - 2;
+    mir_task_create((mir_tfunc_t)ol_fib_0, (void*)&imm_args_1, sizeof(data_env_0_t), 0, NULL, "ol_fib_0");
+
+    mir_task_wait();
+
+    return x + y;
+} /*}}}*/
+
+// Each task waits for a single child
+uint64_t chain(int n)
+{ /*{{{*/
+    uint64_t x;
+    if (n == 0)
+        return 0;
+
+    data_env_0_t imm_args_0;
+    imm_args_0.x_0 = &(x);
+    imm_args_0.n_0 = n - 1;
+    mir_task_create((mir_tfunc_t)ol_chain_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_chain_0");
+
+    mir_task_wait();
+
+    return x + 1;
+} /*}}}*/
+
+START_TEST(fibers_fib)
+{/*{{{*/
+    mir_create();
+
+    uint64_t result = fib(20);
+
+    mir_destroy();
+
+    ck_assert_int_eq(result, 6765);
+}/*}}}*/
+END_TEST
+
+START_TEST(fibers_chain)
+{/*{{{*/
+    mir_create();
+
+    uint64_t result;
+    data_env_0_t imm_args_0;
+    imm_args_0.x_0 = &(result);
+    imm_args_0.n_0 = CHAIN_LENGTH;
+    mir_task_create((mir_tfunc_t)ol_chain_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_chain_0");
+
+    mir_task_wait();
+
+    mir_destroy();
+
+    ck_assert_int_eq(result, CHAIN_LENGTH);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("fibers");
+    tcase_add_test(tc, fibers_fib);
+    tcase_add_test(tc, fibers_chain);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
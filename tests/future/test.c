@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    long n_0;
+} data_env_0_t; /*}}}*/
+
+void* ol_fib_0(data_env_0_t* arg)
+{ /*{{{*/
+    long n = arg->n_0;
+    if (n < 2)
+        return (void*)n;
+
+    struct mir_future_t* f[2];
+    for (int i = 0; i < 2; i++) {
+        data_env_0_t imm_args_0;
+        imm_args_0.n_0 = n - i - 1;
+        f[i] = mir_task_create_future((mir_tfunc_t)ol_fib_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_fib_0");
+    }
+
+    // Join on each child only
+    long sum = 0;
+    for (int i = 0; i < 2; i++) {
+        sum += (long)mir_future_get(f[i]);
+        mir_future_destroy(f[i]);
+    }
+
+    return (void*)sum;
+} /*}}}*/
+
+START_TEST(future_fib)
+{/*{{{*/
+    mir_create();
+
+    data_env_0_t imm_args_0;
+    imm_args_0.n_0 = 20;
+    struct mir_future_t* f = mir_task_create_future((mir_tfunc_t)ol_fib_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_fib_0");
+    long result = (long)mir_future_get(f);
+    ck_assert_int_eq(mir_future_done(f), 1);
+    mir_future_destroy(f);
+
+    mir_task_wait();
+
+    mir_destroy();
+
+    ck_assert_int_eq(result, 6765);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("future");
+    tcase_add_test(tc, future_fib);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
@@ -29,12 +29,35 @@ START_TEST(omp_atomic)
 }/*}}}*/
 END_TEST
 
+START_TEST(omp_atomic_long_double)
+{/*{{{*/
+    // No hardware support, updated through GOMP_atomic_start
+    long double a = 0;
+    long double b = 0;
+
+#pragma omp parallel shared(a, b)
+    {
+        for(int i=0; i<1000; i++)
+        {
+#pragma omp atomic
+            a += 1.0L;
+#pragma omp atomic
+            b -= 1.0L;
+        }
+    }
+
+    ck_assert(a == -b);
+    ck_assert(a > 0);
+}/*}}}*/
+END_TEST
+
 Suite* test_suite(void)
 {/*{{{*/
     Suite* s = suite_create("Test");
 
     TCase* tc = tcase_create("omp_atomic");
     tcase_add_test(tc, omp_atomic);
+    tcase_add_test(tc, omp_atomic_long_double);
 
     suite_add_tcase(s, tc);
 
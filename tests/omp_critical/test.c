@@ -91,6 +91,35 @@ START_TEST(omp_critical_named)
 }/*}}}*/
 END_TEST
 
+START_TEST(omp_critical_names)
+{/*{{{*/
+    int a = 0;
+    int b = 0;
+    int c = 0;
+    int nthreads = 0;
+
+#pragma omp parallel shared(a, b, c, nthreads)
+    {
+#pragma omp single
+        nthreads = omp_get_num_threads();
+
+        for(int i=0; i<1000; i++)
+        {
+#pragma omp critical(a_crit_sec)
+            a++;
+#pragma omp critical(b_crit_sec)
+            b++;
+#pragma omp critical
+            c++;
+        }
+    }
+
+    ck_assert_int_eq(a, 1000 * nthreads);
+    ck_assert_int_eq(b, 1000 * nthreads);
+    ck_assert_int_eq(c, 1000 * nthreads);
+}/*}}}*/
+END_TEST
+
 Suite* test_suite(void)
 {/*{{{*/
     Suite* s = suite_create("Test");
@@ -98,6 +127,7 @@ Suite* test_suite(void)
     TCase* tc = tcase_create("omp_critical");
     tcase_add_test(tc, omp_critical);
     tcase_add_test(tc, omp_critical_named);
+    tcase_add_test(tc, omp_critical_names);
 
     suite_add_tcase(s, tc);
 
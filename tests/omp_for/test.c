@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <check.h>
 #include <omp.h>
+#include "mir_public_int.h"
 
 START_TEST(omp_parallel_for)
 {/*{{{*/
@@ -1116,6 +1117,117 @@ START_TEST(omp_for_runtime_guided_chunk)
 }/*}}}*/
 END_TEST
 
+START_TEST(omp_for_runtime_adaptive)
+{/*{{{*/
+    int a[1024] = {0};
+
+    setenv("OMP_SCHEDULE", "adaptive", 1);
+
+    // Later iterations cost more
+#pragma omp parallel shared(a)
+    {
+#pragma omp for schedule(runtime)
+        for(int i=0; i<1024; i++)
+        {
+            for(int j=0; j<=i; j++)
+                a[i] += 1;
+        }
+    }
+
+    unsetenv("OMP_SCHEDULE");
+
+    for(int i=0; i<1024; i++)
+        ck_assert_int_eq(a[i], i + 1);
+}/*}}}*/
+END_TEST
+
+START_TEST(omp_for_runtime_adaptive_chunk)
+{/*{{{*/
+    int a[128] = {0};
+
+    setenv("OMP_SCHEDULE", "adaptive,10", 1);
+
+#pragma omp parallel shared(a)
+    {
+#pragma omp for schedule(runtime)
+        for(int i=0; i<128; i++)
+        {
+            a[i] = i;
+        }
+    }
+
+    unsetenv("OMP_SCHEDULE");
+
+    int sum = 0;
+    int sum_gold = 0;
+    for(int i=0; i<128; i++)
+    {
+        sum += a[i];
+        sum_gold += i;
+    }
+    ck_assert_int_eq(sum, sum_gold);
+}/*}}}*/
+END_TEST
+
+START_TEST(omp_for_runtime_affinity)
+{/*{{{*/
+    int a[1024] = {0};
+
+    setenv("OMP_SCHEDULE", "affinity", 1);
+
+    // Repeated instances replay the partition of the previous one
+    for(int k=0; k<10; k++)
+    {
+#pragma omp parallel shared(a)
+        {
+#pragma omp for schedule(runtime)
+            for(int i=0; i<1024; i++)
+            {
+                for(int j=0; j<=i; j++)
+                    a[i] += 1;
+            }
+        }
+    }
+
+    unsetenv("OMP_SCHEDULE");
+
+    for(int i=0; i<1024; i++)
+        ck_assert_int_eq(a[i], 10 * (i + 1));
+}/*}}}*/
+END_TEST
+
+START_TEST(omp_for_runtime_numa)
+{/*{{{*/
+    double* a = malloc(65536 * sizeof(double));
+
+    setenv("OMP_SCHEDULE", "numa", 1);
+
+    // Place the pages by first touch
+#pragma omp parallel for schedule(static)
+    for(int i=0; i<65536; i++)
+        a[i] = 0;
+
+    mir_loop_set_footprint(a, sizeof(double));
+
+#pragma omp parallel shared(a)
+    {
+#pragma omp for schedule(runtime)
+        for(int i=0; i<65536; i++)
+        {
+            a[i] += i;
+        }
+    }
+
+    mir_loop_set_footprint(NULL, 0);
+    unsetenv("OMP_SCHEDULE");
+
+    for(int i=0; i<65536; i++)
+        ck_assert(a[i] == i);
+
+    free(a);
+}/*}}}*/
+END_TEST
+
 Suite* test_suite(void)
 {/*{{{*/
     Suite* s = suite_create("Test");
@@ -1179,6 +1291,13 @@ Suite* test_suite(void)
     tcase_add_test(tc, omp_for_runtime_guided);
     tcase_add_test(tc, omp_for_runtime_guided_chunk);
 
+    tcase_add_test(tc, omp_for_runtime_adaptive);
+    tcase_add_test(tc, omp_for_runtime_adaptive_chunk);
+
+    tcase_add_test(tc, omp_for_runtime_affinity);
+
+    tcase_add_test(tc, omp_for_runtime_numa);
+
     suite_add_tcase(s, tc);
 
     return s;
@@ -0,0 +1,179 @@
+#include <stdlib.h>
+#include <check.h>
+#include <omp.h>
+
+START_TEST(omp_lock_set)
+{/*{{{*/
+    int a = 0;
+    int nthreads = 0;
+    omp_lock_t lock;
+    omp_init_lock(&lock);
+
+#pragma omp parallel shared(a, nthreads, lock)
+    {
+#pragma omp single
+        nthreads = omp_get_num_threads();
+
+        for(int i=0; i<1000; i++)
+        {
+            omp_set_lock(&lock);
+            a++;
+            omp_unset_lock(&lock);
+        }
+    }
+
+    omp_destroy_lock(&lock);
+
+    ck_assert_int_eq(a, 1000 * nthreads);
+}/*}}}*/
+END_TEST
+
+START_TEST(omp_lock_tasks)
+{/*{{{*/
+    int a = 0;
+    omp_lock_t lock;
+    omp_init_lock(&lock);
+
+#pragma omp parallel shared(a, lock)
+    {
+#pragma omp single
+        {
+            for(int i=0; i<1000; i++)
+            {
+#pragma omp task shared(a, lock)
+                {
+                    omp_set_lock(&lock);
+                    a++;
+                    omp_unset_lock(&lock);
+                }
+            }
+        }
+    }
+
+    omp_destroy_lock(&lock);
+
+    ck_assert_int_eq(a, 1000);
+}/*}}}*/
+END_TEST
+
+START_TEST(omp_lock_test)
+{/*{{{*/
+    int a = 0;
+    int taken = 0;
+    omp_lock_t lock;
+    omp_init_lock(&lock);
+
+    ck_assert_int_ne(omp_test_lock(&lock), 0);
+    ck_assert_int_eq(omp_test_lock(&lock), 0);
+    omp_unset_lock(&lock);
+
+#pragma omp parallel shared(a, taken, lock)
+    {
+        for(int i=0; i<1000; i++)
+        {
+            if(omp_test_lock(&lock))
+            {
+                a++;
+                taken++;
+                omp_unset_lock(&lock);
+            }
+        }
+    }
+
+    omp_destroy_lock(&lock);
+
+    ck_assert_int_eq(a, taken);
+    ck_assert_int_gt(taken, 0);
+}/*}}}*/
+END_TEST
+
+START_TEST(omp_nest_lock_set)
+{/*{{{*/
+    int a = 0;
+    int nthreads = 0;
+    omp_nest_lock_t lock;
+    omp_init_nest_lock(&lock);
+
+#pragma omp parallel shared(a, nthreads, lock)
+    {
+#pragma omp single
+        nthreads = omp_get_num_threads();
+
+        for(int i=0; i<1000; i++)
+        {
+            omp_set_nest_lock(&lock);
+            omp_set_nest_lock(&lock);
+            a++;
+            omp_unset_nest_lock(&lock);
+            a++;
+            omp_unset_nest_lock(&lock);
+        }
+    }
+
+    omp_destroy_nest_lock(&lock);
+
+    ck_assert_int_eq(a, 2000 * nthreads);
+}/*}}}*/
+END_TEST
+
+START_TEST(omp_nest_lock_test)
+{/*{{{*/
+    int held_elsewhere = 0;
+    omp_nest_lock_t lock;
+    omp_init_nest_lock(&lock);
+
+    // Tests by the owner return the nesting depth
+    ck_assert_int_eq(omp_test_nest_lock(&lock), 1);
+    ck_assert_int_eq(omp_test_nest_lock(&lock), 2);
+    omp_set_nest_lock(&lock);
+    ck_assert_int_eq(omp_test_nest_lock(&lock), 4);
+
+#pragma omp parallel num_threads(2) shared(held_elsewhere, lock)
+    {
+#pragma omp single
+        {
+#pragma omp task shared(held_elsewhere, lock)
+            {
+                held_elsewhere = omp_test_nest_lock(&lock) == 0;
+            }
+        }
+    }
+
+    for(int i=0; i<4; i++)
+        omp_unset_nest_lock(&lock);
+    omp_destroy_nest_lock(&lock);
+
+    ck_assert_int_eq(held_elsewhere, 1);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s = suite_create("Test");
+
+    TCase* tc = tcase_create("omp_lock");
+    tcase_add_test(tc, omp_lock_set);
+    tcase_add_test(tc, omp_lock_tasks);
+    tcase_add_test(tc, omp_lock_test);
+    tcase_add_test(tc, omp_nest_lock_set);
+    tcase_add_test(tc, omp_nest_lock_test);
+
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
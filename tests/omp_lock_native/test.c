@@ -0,0 +1,311 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define NUM_ITERS 10000
+#define GUARD 0x5A5A5A5A
+
+// Lock objects as programs allocate them from libgomp's omp.h
+typedef struct { unsigned char _x[4] __attribute__((__aligned__(4))); } omp_lock_t;
+typedef struct { unsigned char _x[8 + sizeof(void*)] __attribute__((__aligned__(8))); } omp_nest_lock_t;
+
+// Locks of the runtime behind the omp_*_lock entry points
+void mir_omp_lock_init(omp_lock_t* lock);
+void mir_omp_lock_destroy(omp_lock_t* lock);
+void mir_omp_lock_set(omp_lock_t* lock);
+void mir_omp_lock_unset(omp_lock_t* lock);
+int mir_omp_lock_test(omp_lock_t* lock);
+void mir_omp_nest_lock_init(omp_nest_lock_t* lock);
+void mir_omp_nest_lock_destroy(omp_nest_lock_t* lock);
+void mir_omp_nest_lock_set(omp_nest_lock_t* lock);
+void mir_omp_nest_lock_unset(omp_nest_lock_t* lock);
+int mir_omp_nest_lock_test(omp_nest_lock_t* lock);
+
+// Locks behind the GOMP_critical_* and GOMP_atomic_* entry points
+void mir_omp_critical_start();
+void mir_omp_critical_end();
+void mir_omp_critical_name_start(void** pptr);
+void mir_omp_critical_name_end(void** pptr);
+void mir_omp_atomic_start(void* addr);
+void mir_omp_atomic_end(void* addr);
+
+// Writes past the libgomp size show in the guards
+static struct {
+    omp_lock_t lock;
+    uint32_t guard;
+} g_lock;
+
+static struct {
+    omp_nest_lock_t lock;
+    uint32_t guard;
+} g_nest_lock;
+
+static long a;
+static long taken;
+
+static void set_body(long start, long end, void* arg)
+{ /*{{{*/
+    for (long i = start; i < end; i++) {
+        mir_omp_lock_set(&g_lock.lock);
+        a++;
+        mir_omp_lock_unset(&g_lock.lock);
+    }
+} /*}}}*/
+
+START_TEST(omp_lock_native_set)
+{/*{{{*/
+    a = 0;
+    g_lock.guard = GUARD;
+
+    mir_create();
+
+    mir_omp_lock_init(&g_lock.lock);
+    mir_loop_parallel(set_body, NULL, 0, NUM_ITERS, "dynamic,1");
+    mir_omp_lock_destroy(&g_lock.lock);
+
+    mir_destroy();
+
+    ck_assert_int_eq(a, NUM_ITERS);
+    ck_assert_int_eq(g_lock.guard, GUARD);
+}/*}}}*/
+END_TEST
+
+void ol_set_0(void* arg)
+{ /*{{{*/
+    mir_omp_lock_set(&g_lock.lock);
+    a++;
+    mir_omp_lock_unset(&g_lock.lock);
+} /*}}}*/
+
+START_TEST(omp_lock_native_tasks)
+{/*{{{*/
+    a = 0;
+
+    mir_create();
+
+    mir_omp_lock_init(&g_lock.lock);
+    for (int i = 0; i < NUM_ITERS; i++)
+        mir_task_create((mir_tfunc_t)ol_set_0, NULL, 0, 0, NULL, "ol_set_0");
+    mir_task_wait();
+    mir_omp_lock_destroy(&g_lock.lock);
+
+    mir_destroy();
+
+    ck_assert_int_eq(a, NUM_ITERS);
+}/*}}}*/
+END_TEST
+
+static void test_body(long start, long end, void* arg)
+{ /*{{{*/
+    for (long i = start; i < end; i++) {
+        if (mir_omp_lock_test(&g_lock.lock)) {
+            a++;
+            taken++;
+            mir_omp_lock_unset(&g_lock.lock);
+        }
+    }
+} /*}}}*/
+
+START_TEST(omp_lock_native_test)
+{/*{{{*/
+    a = 0;
+    taken = 0;
+
+    mir_create();
+
+    mir_omp_lock_init(&g_lock.lock);
+    ck_assert_int_ne(mir_omp_lock_test(&g_lock.lock), 0);
+    ck_assert_int_eq(mir_omp_lock_test(&g_lock.lock), 0);
+    mir_omp_lock_unset(&g_lock.lock);
+
+    mir_loop_parallel(test_body, NULL, 0, NUM_ITERS, "dynamic,1");
+    mir_omp_lock_destroy(&g_lock.lock);
+
+    mir_destroy();
+
+    ck_assert_int_eq(a, taken);
+    ck_assert_int_gt(taken, 0);
+}/*}}}*/
+END_TEST
+
+static void nest_body(long start, long end, void* arg)
+{ /*{{{*/
+    for (long i = start; i < end; i++) {
+        mir_omp_nest_lock_set(&g_nest_lock.lock);
+        mir_omp_nest_lock_set(&g_nest_lock.lock);
+        a++;
+        mir_omp_nest_lock_unset(&g_nest_lock.lock);
+        a++;
+        mir_omp_nest_lock_unset(&g_nest_lock.lock);
+    }
+} /*}}}*/
+
+START_TEST(omp_nest_lock_native_set)
+{/*{{{*/
+    a = 0;
+    g_nest_lock.guard = GUARD;
+
+    mir_create();
+
+    mir_omp_nest_lock_init(&g_nest_lock.lock);
+    mir_loop_parallel(nest_body, NULL, 0, NUM_ITERS, "dynamic,1");
+    mir_omp_nest_lock_destroy(&g_nest_lock.lock);
+
+    mir_destroy();
+
+    ck_assert_int_eq(a, 2 * NUM_ITERS);
+    ck_assert_int_eq(g_nest_lock.guard, GUARD);
+}/*}}}*/
+END_TEST
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    int* held_elsewhere_0;
+} data_env_0_t; /*}}}*/
+
+void ol_nest_test_0(data_env_0_t* arg)
+{ /*{{{*/
+    *arg->held_elsewhere_0 = mir_omp_nest_lock_test(&g_nest_lock.lock) == 0;
+} /*}}}*/
+
+START_TEST(omp_nest_lock_native_test)
+{/*{{{*/
+    int held_elsewhere = 0;
+
+    mir_create();
+
+    mir_omp_nest_lock_init(&g_nest_lock.lock);
+
+    // Tests by the owner return the nesting depth
+    ck_assert_int_eq(mir_omp_nest_lock_test(&g_nest_lock.lock), 1);
+    ck_assert_int_eq(mir_omp_nest_lock_test(&g_nest_lock.lock), 2);
+    mir_omp_nest_lock_set(&g_nest_lock.lock);
+    ck_assert_int_eq(mir_omp_nest_lock_test(&g_nest_lock.lock), 4);
+
+    // Tasks are other owners
+    data_env_0_t imm_args_0;
+    imm_args_0.held_elsewhere_0 = &held_elsewhere;
+    mir_task_create((mir_tfunc_t)ol_nest_test_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_nest_test_0");
+    mir_task_wait();
+
+    for (int i = 0; i < 4; i++)
+        mir_omp_nest_lock_unset(&g_nest_lock.lock);
+    mir_omp_nest_lock_destroy(&g_nest_lock.lock);
+
+    mir_destroy();
+
+    ck_assert_int_eq(held_elsewhere, 1);
+}/*}}}*/
+END_TEST
+
+// Slots the compiler emits for two critical section names
+static void* g_critical_a;
+static void* g_critical_b;
+static long b;
+
+static void critical_body(long start, long end, void* arg)
+{ /*{{{*/
+    for (long i = start; i < end; i++) {
+        mir_omp_critical_start();
+        taken++;
+        mir_omp_critical_end();
+        mir_omp_critical_name_start(&g_critical_a);
+        a++;
+        mir_omp_critical_name_end(&g_critical_a);
+        mir_omp_critical_name_start(&g_critical_b);
+        b++;
+        mir_omp_critical_name_end(&g_critical_b);
+    }
+} /*}}}*/
+
+START_TEST(omp_critical_native)
+{/*{{{*/
+    a = 0;
+    b = 0;
+    taken = 0;
+
+    mir_create();
+
+    mir_loop_parallel(critical_body, NULL, 0, NUM_ITERS, "dynamic,1");
+
+    mir_destroy();
+
+    ck_assert_int_eq(taken, NUM_ITERS);
+    ck_assert_int_eq(a, NUM_ITERS);
+    ck_assert_int_eq(b, NUM_ITERS);
+    // Free locks leave the slots as the compiler emitted them
+    ck_assert(g_critical_a == NULL && g_critical_b == NULL);
+}/*}}}*/
+END_TEST
+
+#define NUM_VARS 16
+
+static long long g_vars[NUM_VARS];
+
+// Updates of different addresses mostly take different stripe locks
+static void atomic_body(long start, long end, void* arg)
+{ /*{{{*/
+    for (long i = start; i < end; i++) {
+        long long* var = &g_vars[i % NUM_VARS];
+        mir_omp_atomic_start(var);
+        *var += i;
+        mir_omp_atomic_end(var);
+        mir_omp_atomic_start(NULL);
+        a++;
+        mir_omp_atomic_end(NULL);
+    }
+} /*}}}*/
+
+START_TEST(omp_atomic_native)
+{/*{{{*/
+    a = 0;
+    for (int v = 0; v < NUM_VARS; v++)
+        g_vars[v] = 0;
+
+    mir_create();
+
+    mir_loop_parallel(atomic_body, NULL, 0, NUM_ITERS, "dynamic,1");
+
+    mir_destroy();
+
+    long long sum = 0;
+    for (int v = 0; v < NUM_VARS; v++)
+        sum += g_vars[v];
+    ck_assert(sum == (long long)NUM_ITERS * (NUM_ITERS - 1) / 2);
+    ck_assert_int_eq(a, NUM_ITERS);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("omp_lock_native");
+    tcase_add_test(tc, omp_lock_native_set);
+    tcase_add_test(tc, omp_lock_native_tasks);
+    tcase_add_test(tc, omp_lock_native_test);
+    tcase_add_test(tc, omp_nest_lock_native_set);
+    tcase_add_test(tc, omp_nest_lock_native_test);
+    tcase_add_test(tc, omp_critical_native);
+    tcase_add_test(tc, omp_atomic_native);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
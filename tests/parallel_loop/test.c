@@ -0,0 +1,222 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define NUM_ITERS 100000
+#define NUM_LOOPS 1000
+
+static uint32_t counts[NUM_ITERS];
+
+// Counts executions of each iteration
+static void count_body(long start, long end, void* arg)
+{ /*{{{*/
+    uint64_t* sum = (uint64_t*)arg;
+    uint64_t local = 0;
+    for (long i = start; i < end; i++) {
+        __sync_fetch_and_add(&counts[i], 1);
+        local += i;
+    }
+    __sync_fetch_and_add(sum, local);
+} /*}}}*/
+
+// Each iteration is executed exactly once
+static int run_once(const char* schedule)
+{ /*{{{*/
+    uint64_t sum = 0;
+    for (long i = 0; i < NUM_ITERS; i++)
+        counts[i] = 0;
+
+    mir_loop_parallel(count_body, &sum, 0, NUM_ITERS, schedule);
+
+    for (long i = 0; i < NUM_ITERS; i++)
+        if (counts[i] != 1)
+            return 0;
+    return sum == (uint64_t)NUM_ITERS * (NUM_ITERS - 1) / 2;
+} /*}}}*/
+
+START_TEST(parallel_loop_static)
+{/*{{{*/
+    mir_create();
+
+    ck_assert(run_once(NULL));
+    ck_assert(run_once("static"));
+    ck_assert(run_once("static,7"));
+
+    mir_destroy();
+}/*}}}*/
+END_TEST
+
+START_TEST(parallel_loop_dynamic)
+{/*{{{*/
+    mir_create();
+
+    ck_assert(run_once("dynamic"));
+    ck_assert(run_once("dynamic,13"));
+    ck_assert(run_once("guided"));
+    ck_assert(run_once("guided,100"));
+
+    mir_destroy();
+}/*}}}*/
+END_TEST
+
+static uint64_t fib_seq(int n)
+{ /*{{{*/
+    if (n < 2)
+        return n;
+    return fib_seq(n - 1) + fib_seq(n - 2);
+} /*}}}*/
+
+// Iterations get costlier towards the end
+static void irregular_body(long start, long end, void* arg)
+{ /*{{{*/
+    uint64_t* sum = (uint64_t*)arg;
+    uint64_t local = 0;
+    for (long i = start; i < end; i++)
+        local += fib_seq(i * 20 / NUM_ITERS);
+    __sync_fetch_and_add(sum, local);
+} /*}}}*/
+
+START_TEST(parallel_loop_adaptive)
+{/*{{{*/
+    uint64_t sum = 0;
+    uint64_t expected = 0;
+    for (long i = 0; i < NUM_ITERS; i++)
+        expected += fib_seq(i * 20 / NUM_ITERS);
+
+    mir_create();
+
+    ck_assert(run_once("adaptive"));
+    ck_assert(run_once("adaptive,16"));
+    // Idle threads steal from the costly ranges
+    mir_loop_parallel(irregular_body, &sum, 0, NUM_ITERS, "adaptive");
+
+    mir_destroy();
+
+    ck_assert(sum == expected);
+}/*}}}*/
+END_TEST
+
+// Instances of the same loop replay the shares of the last one
+START_TEST(parallel_loop_affinity)
+{/*{{{*/
+    uint64_t expected = 0;
+    for (long i = 0; i < NUM_ITERS; i++)
+        expected += fib_seq(i * 20 / NUM_ITERS);
+
+    mir_create();
+
+    for (int l = 0; l < 10; l++) {
+        uint64_t sum = 0;
+        mir_loop_parallel(irregular_body, &sum, 0, NUM_ITERS, "affinity");
+        ck_assert(sum == expected);
+    }
+    for (int l = 0; l < 3; l++)
+        ck_assert(run_once("affinity,8"));
+
+    mir_destroy();
+}/*}}}*/
+END_TEST
+
+// Ranges follow the pages of the registered footprint
+START_TEST(parallel_loop_numa)
+{/*{{{*/
+    mir_create();
+
+    ck_assert(run_once("numa"));
+    mir_loop_set_footprint(counts, sizeof(counts[0]));
+    ck_assert(run_once("numa"));
+    ck_assert(run_once("numa,32"));
+    mir_loop_set_footprint(NULL, 0);
+
+    mir_destroy();
+}/*}}}*/
+END_TEST
+
+static void sum_body(long start, long end, void* arg)
+{ /*{{{*/
+    uint64_t* sum = (uint64_t*)arg;
+    uint64_t local = 0;
+    for (long i = start; i < end; i++)
+        local += i;
+    __sync_fetch_and_add(sum, local);
+} /*}}}*/
+
+// Back-to-back loops reuse pooled teams
+START_TEST(parallel_loop_repeated)
+{/*{{{*/
+    uint64_t sum = 0;
+
+    mir_create();
+
+    for (int l = 0; l < NUM_LOOPS; l++)
+        mir_loop_parallel(sum_body, &sum, 0, 100, NULL);
+    mir_loop_parallel(sum_body, &sum, 5, 5, NULL);
+
+    mir_destroy();
+
+    ck_assert(sum == (uint64_t)NUM_LOOPS * 4950);
+}/*}}}*/
+END_TEST
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    uint64_t* sum_0;
+} data_env_0_t; /*}}}*/
+
+void ol_loops_0(data_env_0_t* arg)
+{ /*{{{*/
+    for (int l = 0; l < 10; l++)
+        mir_loop_parallel(sum_body, arg->sum_0, 0, 100, "static,3");
+} /*}}}*/
+
+// Loops started by tasks
+START_TEST(parallel_loop_in_task)
+{/*{{{*/
+    uint64_t sum = 0;
+
+    mir_create();
+
+    data_env_0_t imm_args_0;
+    imm_args_0.sum_0 = &sum;
+    mir_task_create((mir_tfunc_t)ol_loops_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_loops_0");
+    mir_task_wait();
+
+    mir_destroy();
+
+    ck_assert(sum == 10 * 4950);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("parallel_loop");
+    tcase_add_test(tc, parallel_loop_static);
+    tcase_add_test(tc, parallel_loop_dynamic);
+    tcase_add_test(tc, parallel_loop_adaptive);
+    tcase_add_test(tc, parallel_loop_affinity);
+    tcase_add_test(tc, parallel_loop_numa);
+    tcase_add_test(tc, parallel_loop_repeated);
+    tcase_add_test(tc, parallel_loop_in_task);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define NUM_TASKS 512
+#define BLOCK_SIZE 64
+
+static uint64_t blocks[NUM_TASKS][BLOCK_SIZE];
+static volatile uint32_t num_executed = 0;
+static volatile uint32_t num_on_hinted_worker = 0;
+static volatile uint32_t num_bad_blocks = 0;
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    int i_0;
+    int worker_0;
+} data_env_0_t; /*}}}*/
+
+void ol_produce_0(data_env_0_t* arg)
+{ /*{{{*/
+    for (int j = 0; j < BLOCK_SIZE; j++)
+        blocks[arg->i_0][j] = arg->i_0 + j;
+    if (mir_get_threadid() == arg->worker_0)
+        __sync_fetch_and_add(&num_on_hinted_worker, 1);
+    __sync_fetch_and_add(&num_executed, 1);
+} /*}}}*/
+
+void ol_consume_0(data_env_0_t* arg)
+{ /*{{{*/
+    uint64_t sum = 0;
+    for (int j = 0; j < BLOCK_SIZE; j++)
+        sum += blocks[arg->i_0][j];
+    if (sum != arg->i_0 * BLOCK_SIZE + (BLOCK_SIZE * (BLOCK_SIZE - 1)) / 2)
+        __sync_fetch_and_add(&num_bad_blocks, 1);
+    __sync_fetch_and_add(&num_executed, 1);
+} /*}}}*/
+
+START_TEST(task_affinity)
+{/*{{{*/
+    mir_create();
+
+    int num_workers = mir_get_num_threads();
+
+    // Produce blocks on hinted workers
+    for (int i = 0; i < NUM_TASKS; i++) {
+        struct mir_data_footprint_t footprint;
+        footprint.base = &blocks[i][0];
+        footprint.type = sizeof(uint64_t);
+        footprint.start = 0;
+        footprint.end = BLOCK_SIZE - 1;
+        footprint.row_sz = 1;
+        footprint.data_access = MIR_DATA_ACCESS_WRITE;
+        footprint.part_of = blocks;
+
+        struct mir_task_attr_t attr;
+        mir_task_attr_init(&attr);
+        attr.worker = i % num_workers;
+
+        data_env_0_t imm_args_0;
+        imm_args_0.i_0 = i;
+        imm_args_0.worker_0 = attr.worker;
+        mir_task_create_attr((mir_tfunc_t)ol_produce_0, (void*)&imm_args_0, sizeof(data_env_0_t), 1, &footprint, "ol_produce_0", &attr);
+    }
+    mir_task_wait();
+
+    // Consume blocks near their producers
+    for (int i = 0; i < NUM_TASKS; i++) {
+        struct mir_task_attr_t attr;
+        mir_task_attr_init(&attr);
+        attr.near = &blocks[i][0];
+
+        data_env_0_t imm_args_0;
+        imm_args_0.i_0 = i;
+        imm_args_0.worker_0 = -1;
+        mir_task_create_attr((mir_tfunc_t)ol_consume_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_consume_0", &attr);
+    }
+    mir_task_wait();
+
+    mir_destroy();
+
+    // Hints are soft, so tasks may be stolen, but none may be lost
+    ck_assert_int_eq(num_executed, 2 * NUM_TASKS);
+    ck_assert_int_eq(num_bad_blocks, 0);
+    ck_assert_int_gt(num_on_hinted_worker, 0);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("task_affinity");
+    tcase_add_test(tc, task_affinity);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
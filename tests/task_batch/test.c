@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define NUM_TASKS 1000
+#define NUM_OUTER 16
+#define NUM_INNER 64
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    long i_0;
+    long* out_0;
+} data_env_0_t; /*}}}*/
+
+void* ol_square_0(data_env_0_t* arg)
+{ /*{{{*/
+    arg->out_0[arg->i_0] = arg->i_0 * arg->i_0;
+    return NULL;
+} /*}}}*/
+
+void* ol_outer_0(data_env_0_t* arg)
+{ /*{{{*/
+    data_env_0_t args[NUM_INNER];
+    for (long i = 0; i < NUM_INNER; i++) {
+        args[i].i_0 = arg->i_0 * NUM_INNER + i;
+        args[i].out_0 = arg->out_0;
+    }
+    mir_task_create_batch((mir_tfunc_t)ol_square_0, (void*)args, sizeof(data_env_0_t), NUM_INNER, "ol_square_0");
+
+    mir_task_wait();
+
+    return NULL;
+} /*}}}*/
+
+START_TEST(task_batch_flat)
+{/*{{{*/
+    mir_create();
+
+    long* out = malloc(NUM_TASKS * sizeof(long));
+    data_env_0_t* args = malloc(NUM_TASKS * sizeof(data_env_0_t));
+    for (long i = 0; i < NUM_TASKS; i++) {
+        out[i] = -1;
+        args[i].i_0 = i;
+        args[i].out_0 = out;
+    }
+    mir_task_create_batch((mir_tfunc_t)ol_square_0, (void*)args, sizeof(data_env_0_t), NUM_TASKS, "ol_square_0");
+
+    mir_task_wait();
+
+    mir_destroy();
+
+    for (long i = 0; i < NUM_TASKS; i++)
+        ck_assert_int_eq(out[i], i * i);
+
+    free(args);
+    free(out);
+}/*}}}*/
+END_TEST
+
+START_TEST(task_batch_nested)
+{/*{{{*/
+    mir_create();
+
+    long* out = malloc(NUM_OUTER * NUM_INNER * sizeof(long));
+    for (long i = 0; i < NUM_OUTER * NUM_INNER; i++)
+        out[i] = -1;
+    data_env_0_t args[NUM_OUTER];
+    for (long i = 0; i < NUM_OUTER; i++) {
+        args[i].i_0 = i;
+        args[i].out_0 = out;
+    }
+    mir_task_create_batch((mir_tfunc_t)ol_outer_0, (void*)args, sizeof(data_env_0_t), NUM_OUTER, "ol_outer_0");
+
+    mir_task_wait();
+
+    mir_destroy();
+
+    for (long i = 0; i < NUM_OUTER * NUM_INNER; i++)
+        ck_assert_int_eq(out[i], i * i);
+
+    free(out);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("task_batch");
+    tcase_add_test(tc, task_batch_flat);
+    tcase_add_test(tc, task_batch_nested);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define NUM_ELEMENTS 100000
+#define NUM_ROUNDS 4
+
+static volatile uint64_t sum = 0;
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    int* a_0;
+    int i_0;
+} data_env_0_t; /*}}}*/
+
+void ol_tiny_0(data_env_0_t* arg)
+{ /*{{{*/
+    arg->a_0[arg->i_0] += 1;
+    __sync_fetch_and_add(&sum, arg->i_0);
+} /*}}}*/
+
+typedef struct data_env_1_t_tag { /*{{{*/
+    int* a_1;
+    int start_1;
+    int end_1;
+} data_env_1_t; /*}}}*/
+
+void ol_spawner_1(data_env_1_t* arg)
+{ /*{{{*/
+    // Many tiny siblings
+    for (int i = arg->start_1; i < arg->end_1; i++) {
+        data_env_0_t imm_args_0;
+        imm_args_0.a_0 = arg->a_1;
+        imm_args_0.i_0 = i;
+        mir_task_create((mir_tfunc_t)ol_tiny_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_tiny_0");
+    }
+    mir_task_wait();
+} /*}}}*/
+
+START_TEST(task_coarsening)
+{/*{{{*/
+    int* a = calloc(NUM_ELEMENTS, sizeof(int));
+    ck_assert(a != NULL);
+
+    mir_create();
+
+    // Later rounds run with measured task cost
+    for (int r = 0; r < NUM_ROUNDS; r++) {
+        int num_spawners = 4;
+        for (int j = 0; j < num_spawners; j++) {
+            data_env_1_t imm_args_1;
+            imm_args_1.a_1 = a;
+            imm_args_1.start_1 = j * (NUM_ELEMENTS / num_spawners);
+            imm_args_1.end_1 = (j + 1) * (NUM_ELEMENTS / num_spawners);
+            mir_task_create((mir_tfunc_t)ol_spawner_1, (void*)&imm_args_1, sizeof(data_env_1_t), 0, NULL, "ol_spawner_1");
+        }
+        mir_task_wait();
+    }
+
+    // Tiny tasks created outside tasks
+    for (int i = 0; i < NUM_ELEMENTS; i++) {
+        data_env_0_t imm_args_0;
+        imm_args_0.a_0 = a;
+        imm_args_0.i_0 = i;
+        mir_task_create((mir_tfunc_t)ol_tiny_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_tiny_0");
+    }
+    mir_task_wait();
+
+    mir_destroy();
+
+    for (int i = 0; i < NUM_ELEMENTS; i++)
+        ck_assert_int_eq(a[i], NUM_ROUNDS + 1);
+    ck_assert(sum == (uint64_t)(NUM_ROUNDS + 1) * NUM_ELEMENTS * (NUM_ELEMENTS - 1) / 2);
+
+    free(a);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("task_coarsening");
+    tcase_add_test(tc, task_coarsening);
+    tcase_set_timeout(tc, 20);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
@@ -0,0 +1,263 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define NUM_TASKS 64
+#define NUM_READERS 16
+#define NUM_ROUNDS 8
+
+// Entry of the OpenMP support, which takes depend arrays as emitted by GCC:
+// ... the number of addresses, the number of out and inout addresses,
+// ... then the addresses with out and inout ones first.
+// Since GCC 9 the array starts with 0, the number of addresses and the
+// ... numbers of out/inout, mutexinoutset and in addresses, and depend
+// ... objects holding an address and a kind follow the addresses.
+struct mir_omp_team_t;
+void mir_task_create_on_worker_depend(mir_tfunc_t tfunc, void* data, size_t data_size, void** depend, const char* name, struct mir_omp_team_t* myteam);
+
+static int x;
+static int order[NUM_TASKS];
+static int num_done;
+static int seen[NUM_READERS];
+static int num_readers_done;
+static int readers_done_at_write;
+
+static void spin()
+{ /*{{{*/
+    for (volatile int i = 0; i < 1000; i++)
+        ;
+} /*}}}*/
+
+static void create_depend(mir_tfunc_t tfunc, void* data, size_t data_size, int out, const char* name)
+{ /*{{{*/
+    void* depend[3];
+    depend[0] = (void*)(uintptr_t)1;
+    depend[1] = (void*)(uintptr_t)(out ? 1 : 0);
+    depend[2] = &x;
+    mir_task_create_on_worker_depend(tfunc, data, data_size, depend, name, NULL);
+} /*}}}*/
+
+// Kinds of depend objects, as in libgomp
+#define DEPEND_IN 1
+#define DEPEND_INOUT 3
+
+static void create_depend_gcc9(mir_tfunc_t tfunc, void* data, size_t data_size, int out, int obj, const char* name)
+{ /*{{{*/
+    void* dep_obj[2];
+    dep_obj[0] = &x;
+    dep_obj[1] = (void*)(uintptr_t)(out ? DEPEND_INOUT : DEPEND_IN);
+
+    void* depend[6];
+    depend[0] = 0;
+    depend[1] = (void*)(uintptr_t)1;
+    depend[2] = (void*)(uintptr_t)(!obj && out ? 1 : 0);
+    depend[3] = 0;
+    depend[4] = (void*)(uintptr_t)(!obj && !out ? 1 : 0);
+    depend[5] = obj ? (void*)dep_obj : (void*)&x;
+    mir_task_create_on_worker_depend(tfunc, data, data_size, depend, name, NULL);
+} /*}}}*/
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    int i_0;
+} data_env_0_t; /*}}}*/
+
+void ol_chain_0(data_env_0_t* arg)
+{ /*{{{*/
+    spin();
+    order[__sync_fetch_and_add(&num_done, 1)] = arg->i_0;
+    x++;
+} /*}}}*/
+
+void ol_chain_outer_0(void* arg)
+{ /*{{{*/
+    for (int i = 0; i < NUM_TASKS; i++) {
+        data_env_0_t imm_args_0;
+        imm_args_0.i_0 = i;
+        create_depend((mir_tfunc_t)ol_chain_0, (void*)&imm_args_0, sizeof(data_env_0_t), 1, "ol_chain_0");
+    }
+    mir_task_wait();
+} /*}}}*/
+
+// Tasks depending inout on the same address run in creation order
+START_TEST(task_depend_inout_chain)
+{/*{{{*/
+    x = 0;
+    num_done = 0;
+
+    mir_create();
+
+    mir_task_create((mir_tfunc_t)ol_chain_outer_0, NULL, 0, 0, NULL, "ol_chain_outer_0");
+    mir_task_wait();
+
+    mir_destroy();
+
+    ck_assert_int_eq(x, NUM_TASKS);
+    for (int i = 0; i < NUM_TASKS; i++)
+        ck_assert_int_eq(order[i], i);
+}/*}}}*/
+END_TEST
+
+void ol_writer_0(data_env_0_t* arg)
+{ /*{{{*/
+    spin();
+    x = arg->i_0;
+} /*}}}*/
+
+void ol_reader_0(data_env_0_t* arg)
+{ /*{{{*/
+    spin();
+    seen[arg->i_0] = x;
+    __sync_fetch_and_add(&num_readers_done, 1);
+} /*}}}*/
+
+void ol_last_writer_0(data_env_0_t* arg)
+{ /*{{{*/
+    readers_done_at_write = num_readers_done;
+    x = arg->i_0;
+} /*}}}*/
+
+void ol_readers_outer_0(void* arg)
+{ /*{{{*/
+    data_env_0_t imm_args_0;
+
+    imm_args_0.i_0 = 42;
+    create_depend((mir_tfunc_t)ol_writer_0, (void*)&imm_args_0, sizeof(data_env_0_t), 1, "ol_writer_0");
+
+    for (int i = 0; i < NUM_READERS; i++) {
+        imm_args_0.i_0 = i;
+        create_depend((mir_tfunc_t)ol_reader_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, "ol_reader_0");
+    }
+
+    imm_args_0.i_0 = 7;
+    create_depend((mir_tfunc_t)ol_last_writer_0, (void*)&imm_args_0, sizeof(data_env_0_t), 1, "ol_last_writer_0");
+
+    mir_task_wait();
+} /*}}}*/
+
+// Readers wait for the writer before them, the writer after them waits for all of them
+START_TEST(task_depend_readers)
+{/*{{{*/
+    x = 0;
+    num_readers_done = 0;
+    readers_done_at_write = -1;
+
+    mir_create();
+
+    mir_task_create((mir_tfunc_t)ol_readers_outer_0, NULL, 0, 0, NULL, "ol_readers_outer_0");
+    mir_task_wait();
+
+    mir_destroy();
+
+    for (int i = 0; i < NUM_READERS; i++)
+        ck_assert_int_eq(seen[i], 42);
+    ck_assert_int_eq(readers_done_at_write, NUM_READERS);
+    ck_assert_int_eq(x, 7);
+}/*}}}*/
+END_TEST
+
+void ol_readers_gcc9_outer_0(void* arg)
+{ /*{{{*/
+    data_env_0_t imm_args_0;
+
+    imm_args_0.i_0 = 42;
+    create_depend_gcc9((mir_tfunc_t)ol_writer_0, (void*)&imm_args_0, sizeof(data_env_0_t), 1, 0, "ol_writer_0");
+
+    // Readers alternate between addresses and depend objects
+    for (int i = 0; i < NUM_READERS; i++) {
+        imm_args_0.i_0 = i;
+        create_depend_gcc9((mir_tfunc_t)ol_reader_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, i % 2, "ol_reader_0");
+    }
+
+    imm_args_0.i_0 = 7;
+    create_depend_gcc9((mir_tfunc_t)ol_last_writer_0, (void*)&imm_args_0, sizeof(data_env_0_t), 1, 1, "ol_last_writer_0");
+
+    mir_task_wait();
+} /*}}}*/
+
+// Depend arrays in the layout of GCC 9 and later order tasks alike
+START_TEST(task_depend_gcc9_layout)
+{/*{{{*/
+    x = 0;
+    num_readers_done = 0;
+    readers_done_at_write = -1;
+
+    mir_create();
+
+    mir_task_create((mir_tfunc_t)ol_readers_gcc9_outer_0, NULL, 0, 0, NULL, "ol_readers_gcc9_outer_0");
+    mir_task_wait();
+
+    mir_destroy();
+
+    for (int i = 0; i < NUM_READERS; i++)
+        ck_assert_int_eq(seen[i], 42);
+    ck_assert_int_eq(readers_done_at_write, NUM_READERS);
+    ck_assert_int_eq(x, 7);
+}/*}}}*/
+END_TEST
+
+void ol_rounds_outer_0(void* arg)
+{ /*{{{*/
+    for (int r = 0; r < NUM_ROUNDS; r++) {
+        num_done = 0;
+        for (int i = 0; i < NUM_TASKS; i++) {
+            data_env_0_t imm_args_0;
+            imm_args_0.i_0 = i;
+            create_depend((mir_tfunc_t)ol_chain_0, (void*)&imm_args_0, sizeof(data_env_0_t), 1, "ol_chain_0");
+        }
+        // The wait forgets the finished writers of the round
+        mir_task_wait();
+        for (int i = 0; i < NUM_TASKS; i++)
+            if (order[i] != i)
+                x = -1;
+        if (x < 0)
+            return;
+    }
+} /*}}}*/
+
+// Chains created after a taskwait are ordered afresh
+START_TEST(task_depend_taskwait)
+{/*{{{*/
+    x = 0;
+
+    mir_create();
+
+    mir_task_create((mir_tfunc_t)ol_rounds_outer_0, NULL, 0, 0, NULL, "ol_rounds_outer_0");
+    mir_task_wait();
+
+    mir_destroy();
+
+    ck_assert_int_eq(x, NUM_ROUNDS * NUM_TASKS);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("task_depend");
+    tcase_add_test(tc, task_depend_inout_chain);
+    tcase_add_test(tc, task_depend_readers);
+    tcase_add_test(tc, task_depend_taskwait);
+    tcase_add_test(tc, task_depend_gcc9_layout);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define NUM_BLOCKS 16
+#define NUM_STEPS 32
+
+static uint64_t blocks[NUM_BLOCKS];
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    int i_0;
+} data_env_0_t; /*}}}*/
+
+// blocks[i] depends on blocks[i-1] of the same step and blocks[i] of the previous step
+void ol_wavefront_0(data_env_0_t* arg)
+{ /*{{{*/
+    int i = arg->i_0;
+    uint64_t left = i > 0 ? blocks[i - 1] : 1;
+    blocks[i] = (blocks[i] + left) % 1000003;
+} /*}}}*/
+
+static void create_step()
+{ /*{{{*/
+    for (int i = 0; i < NUM_BLOCKS; i++) {
+        struct mir_data_footprint_t footprints[2];
+        footprints[0].base = &blocks[i];
+        footprints[0].type = sizeof(uint64_t);
+        footprints[0].start = 0;
+        footprints[0].end = 0;
+        footprints[0].row_sz = 1;
+        footprints[0].data_access = MIR_DATA_ACCESS_WRITE;
+        footprints[0].part_of = blocks;
+        footprints[1] = footprints[0];
+        footprints[1].base = &blocks[i > 0 ? i - 1 : i];
+        footprints[1].data_access = MIR_DATA_ACCESS_READ;
+
+        data_env_0_t imm_args_0;
+        imm_args_0.i_0 = i;
+
+        mir_task_create((mir_tfunc_t)ol_wavefront_0, (void*)&imm_args_0, sizeof(data_env_0_t), 2, footprints, "ol_wavefront_0");
+    }
+} /*}}}*/
+
+static void init_blocks(uint64_t* expected)
+{ /*{{{*/
+    for (int i = 0; i < NUM_BLOCKS; i++)
+        expected[i] = blocks[i] = i;
+    for (int s = 0; s < NUM_STEPS; s++)
+        for (int i = 0; i < NUM_BLOCKS; i++)
+            expected[i] = (expected[i] + (i > 0 ? expected[i - 1] : 1)) % 1000003;
+} /*}}}*/
+
+START_TEST(task_deps)
+{/*{{{*/
+    uint64_t expected[NUM_BLOCKS];
+    init_blocks(expected);
+
+    mir_create();
+
+    for (int s = 0; s < NUM_STEPS; s++)
+        create_step();
+
+    mir_task_wait();
+
+    mir_destroy();
+
+    for (int i = 0; i < NUM_BLOCKS; i++)
+        ck_assert_int_eq(blocks[i], expected[i]);
+}/*}}}*/
+END_TEST
+
+START_TEST(task_deps_rounds)
+{/*{{{*/
+    uint64_t expected[NUM_BLOCKS];
+    init_blocks(expected);
+
+    mir_create();
+
+    // Dependences are forgotten once the tasks of a step are waited for
+    for (int s = 0; s < NUM_STEPS; s++) {
+        create_step();
+        mir_task_wait();
+    }
+
+    mir_destroy();
+
+    for (int i = 0; i < NUM_BLOCKS; i++)
+        ck_assert_int_eq(blocks[i], expected[i]);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("task_deps");
+    tcase_add_test(tc, task_deps);
+    tcase_add_test(tc, task_deps_rounds);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
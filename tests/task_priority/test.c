@@ -0,0 +1,86 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define NUM_LOW_TASKS 256
+
+static volatile uint32_t exec_counter = 0;
+static uint32_t high_order = 0;
+
+void ol_low_0(void* arg)
+{ /*{{{*/
+    __sync_fetch_and_add(&exec_counter, 1);
+    mir_sleep_us(100);
+} /*}}}*/
+
+void ol_high_0(void* arg)
+{ /*{{{*/
+    high_order = __sync_fetch_and_add(&exec_counter, 1);
+} /*}}}*/
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    uint32_t* started_0;
+} data_env_0_t; /*}}}*/
+
+void ol_root_0(data_env_0_t* arg)
+{ /*{{{*/
+    for (int i = 0; i < NUM_LOW_TASKS; i++)
+        mir_task_create((mir_tfunc_t)ol_low_0, NULL, 0, 0, NULL, "ol_low_0");
+
+    struct mir_task_attr_t attr;
+    mir_task_attr_init(&attr);
+    attr.priority = 3;
+    mir_task_create_attr((mir_tfunc_t)ol_high_0, NULL, 0, 0, NULL, "ol_high_0", &attr);
+    *(arg->started_0) = exec_counter;
+
+    mir_task_wait();
+} /*}}}*/
+
+START_TEST(task_priority)
+{/*{{{*/
+    uint32_t started = 0;
+
+    mir_create();
+
+    data_env_0_t imm_args_0;
+    imm_args_0.started_0 = &started;
+    mir_task_create((mir_tfunc_t)ol_root_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_root_0");
+
+    mir_task_wait();
+
+    // Only tasks already being popped when the high priority task arrived can precede it
+    ck_assert_int_le(high_order, started + mir_get_num_threads());
+    ck_assert_int_eq(exec_counter, NUM_LOW_TASKS + 1);
+
+    mir_destroy();
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("task_priority");
+    tcase_add_test(tc, task_priority);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
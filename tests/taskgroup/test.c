@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define NUM_CANDIDATES 1000
+#define TARGET 10
+
+static volatile uint32_t num_searched = 0;
+static volatile int found = -1;
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    int candidate_0;
+} data_env_0_t; /*}}}*/
+
+void ol_search_0(data_env_0_t* arg)
+{ /*{{{*/
+    __sync_fetch_and_add(&num_searched, 1);
+
+    // Pretend to work, giving up early once cancelled
+    for (int i = 0; i < 10; i++) {
+        if (mir_task_cancelled())
+            return;
+        mir_sleep_us(10);
+    }
+
+    if (arg->candidate_0 == TARGET) {
+        found = arg->candidate_0;
+        mir_taskgroup_cancel();
+    }
+} /*}}}*/
+
+void ol_root_0(void* arg)
+{ /*{{{*/
+    mir_taskgroup_start();
+    for (int i = 0; i < NUM_CANDIDATES; i++) {
+        data_env_0_t imm_args_0;
+        imm_args_0.candidate_0 = i;
+        mir_task_create((mir_tfunc_t)ol_search_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_search_0");
+    }
+    mir_taskgroup_end();
+} /*}}}*/
+
+static volatile uint64_t fib_sum = 0;
+
+typedef struct data_env_1_t_tag { /*{{{*/
+    int n_1;
+} data_env_1_t; /*}}}*/
+
+void ol_fib_1(data_env_1_t* arg)
+{ /*{{{*/
+    // No joins, the group end waits for all descendants
+    int n = arg->n_1;
+    if (n < 2) {
+        __sync_fetch_and_add(&fib_sum, n);
+        return;
+    }
+
+    for (int i = 1; i <= 2; i++) {
+        data_env_1_t imm_args_1;
+        imm_args_1.n_1 = n - i;
+        mir_task_create((mir_tfunc_t)ol_fib_1, (void*)&imm_args_1, sizeof(data_env_1_t), 0, NULL, "ol_fib_1");
+    }
+} /*}}}*/
+
+static volatile int outer_cancelled = 0;
+static volatile int inner_cancelled = 0;
+
+void ol_inner_2(void* arg)
+{ /*{{{*/
+    inner_cancelled = 1;
+} /*}}}*/
+
+void ol_outer_2(void* arg)
+{ /*{{{*/
+    // Cancels the group this task belongs to, not the one it opens
+    mir_taskgroup_start();
+    mir_taskgroup_cancel();
+    outer_cancelled = mir_task_cancelled();
+    mir_task_create((mir_tfunc_t)ol_inner_2, NULL, 0, 0, NULL, "ol_inner_2");
+    mir_taskgroup_end();
+} /*}}}*/
+
+START_TEST(taskgroup_cancel)
+{/*{{{*/
+    mir_create();
+
+    mir_task_create((mir_tfunc_t)ol_root_0, NULL, 0, 0, NULL, "ol_root_0");
+    mir_task_wait();
+
+    mir_destroy();
+
+    ck_assert_int_eq(found, TARGET);
+    ck_assert_int_lt(num_searched, NUM_CANDIDATES);
+}/*}}}*/
+END_TEST
+
+START_TEST(taskgroup_complete)
+{/*{{{*/
+    num_searched = 0;
+    found = -1;
+
+    mir_create();
+
+    // Target is never reached, so nothing is cancelled
+    mir_taskgroup_start();
+    for (int i = TARGET + 1; i < NUM_CANDIDATES / 10; i++) {
+        data_env_0_t imm_args_0;
+        imm_args_0.candidate_0 = i;
+        mir_task_create((mir_tfunc_t)ol_search_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_search_0");
+    }
+    mir_taskgroup_end();
+
+    mir_destroy();
+
+    ck_assert_int_eq(found, -1);
+    ck_assert_int_eq(num_searched, NUM_CANDIDATES / 10 - TARGET - 1);
+}/*}}}*/
+END_TEST
+
+START_TEST(taskgroup_deep)
+{/*{{{*/
+    mir_create();
+
+    mir_taskgroup_start();
+    data_env_1_t imm_args_1;
+    imm_args_1.n_1 = 20;
+    mir_task_create((mir_tfunc_t)ol_fib_1, (void*)&imm_args_1, sizeof(data_env_1_t), 0, NULL, "ol_fib_1");
+    mir_taskgroup_end();
+
+    ck_assert_int_eq(fib_sum, 6765);
+
+    mir_destroy();
+}/*}}}*/
+END_TEST
+
+START_TEST(taskgroup_cancel_nested)
+{/*{{{*/
+    mir_create();
+
+    mir_taskgroup_start();
+    mir_task_create((mir_tfunc_t)ol_outer_2, NULL, 0, 0, NULL, "ol_outer_2");
+    mir_taskgroup_end();
+
+    mir_destroy();
+
+    // Nested groups are cancelled with their enclosing group
+    ck_assert_int_eq(outer_cancelled, 1);
+    ck_assert_int_eq(inner_cancelled, 0);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("taskgroup");
+    tcase_add_test(tc, taskgroup_cancel);
+    tcase_add_test(tc, taskgroup_complete);
+    tcase_add_test(tc, taskgroup_deep);
+    tcase_add_test(tc, taskgroup_cancel_nested);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+#define NUM_ITERS 100000
+
+static uint64_t fib_seq(int n)
+{ /*{{{*/
+    if (n < 2)
+        return n;
+    return fib_seq(n - 1) + fib_seq(n - 2);
+} /*}}}*/
+
+// Irregular iterations
+static void loop_body(long start, long end, void* arg)
+{ /*{{{*/
+    uint64_t* sum = (uint64_t*)arg;
+    uint64_t local = 0;
+    for (long i = start; i < end; i++)
+        local += i + fib_seq(i % 16);
+    __sync_fetch_and_add(sum, local);
+} /*}}}*/
+
+static uint64_t expected_sum()
+{ /*{{{*/
+    uint64_t sum = 0;
+    for (long i = 0; i < NUM_ITERS; i++)
+        sum += i + fib_seq(i % 16);
+    return sum;
+} /*}}}*/
+
+START_TEST(taskloop_grainsize)
+{/*{{{*/
+    uint64_t sum = 0;
+
+    mir_create();
+
+    mir_taskloop(loop_body, &sum, 0, NUM_ITERS, 64, 0);
+
+    mir_destroy();
+
+    ck_assert(sum == expected_sum());
+}/*}}}*/
+END_TEST
+
+START_TEST(taskloop_num_tasks)
+{/*{{{*/
+    uint64_t sum = 0;
+
+    mir_create();
+
+    mir_taskloop(loop_body, &sum, 0, NUM_ITERS, 0, 100);
+
+    mir_destroy();
+
+    ck_assert(sum == expected_sum());
+}/*}}}*/
+END_TEST
+
+// Cancels the enclosing group in the first grain
+static void cancel_body(long start, long end, void* arg)
+{ /*{{{*/
+    uint64_t* count = (uint64_t*)arg;
+    if (start == 0)
+        mir_taskgroup_cancel();
+    __sync_fetch_and_add(count, end - start);
+} /*}}}*/
+
+START_TEST(taskloop_cancel)
+{/*{{{*/
+    uint64_t count = 0;
+
+    mir_create();
+
+    mir_taskgroup_start();
+    mir_taskloop(cancel_body, &count, 0, NUM_ITERS, 16, 0);
+    mir_taskgroup_end();
+
+    mir_destroy();
+
+    ck_assert(count < NUM_ITERS);
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("taskloop");
+    tcase_add_test(tc, taskloop_grainsize);
+    tcase_add_test(tc, taskloop_num_tasks);
+    tcase_add_test(tc, taskloop_cancel);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/
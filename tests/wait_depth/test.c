@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <check.h>
+#include <stdint.h>
+#include "mir_public_int.h"
+
+static uint64_t fib(int n);
+static uint64_t tree(int depth, int width);
+
+typedef struct data_env_0_t_tag { /*{{{*/
+    uint64_t* x_0;
+    int n_0;
+} data_env_0_t; /*}}}*/
+
+typedef struct data_env_1_t_tag { /*{{{*/
+    uint64_t* x_1;
+    int depth_1;
+    int width_1;
+} data_env_1_t; /*}}}*/
+
+void ol_fib_0(data_env_0_t* arg)
+{ /*{{{*/
+    *(arg->x_0) = fib(arg->n_0);
+} /*}}}*/
+
+void ol_tree_1(data_env_1_t* arg)
+{ /*{{{*/
+    *(arg->x_1) = tree(arg->depth_1, arg->width_1);
+} /*}}}*/
+
+uint64_t fib(int n)
+{ /*{{{*/
+    uint64_t x, y;
+    if (n < 2)
+        return n;
+
+    data_env_0_t imm_args_0;
+    imm_args_0.x_0 = &(x);
+    imm_args_0.n_0 = n - 1;
+    mir_task_create((mir_tfunc_t)ol_fib_0, (void*)&imm_args_0, sizeof(data_env_0_t), 0, NULL, "ol_fib_0");
+
+    data_env_0_t imm_args_1;
+    imm_args_1.x_0 = &(y);
+    imm_args_1.n_0 = n - 2;
+    mir_task_create((mir_tfunc_t)ol_fib_0, (void*)&imm_args_1, sizeof(data_env_0_t), 0, NULL, "ol_fib_0");
+
+    mir_task_wait();
+
+    return x + y;
+} /*}}}*/
+
+// Counts nodes of a tree whose first subtree is the deepest
+uint64_t tree(int depth, int width)
+{ /*{{{*/
+    if (depth == 0)
+        return 1;
+
+    uint64_t x[8];
+    for (int i = 0; i < width; i++) {
+        data_env_1_t imm_args_1;
+        imm_args_1.x_1 = &(x[i]);
+        imm_args_1.depth_1 = i == 0 ? depth - 1 : depth / 2;
+        imm_args_1.width_1 = width;
+        mir_task_create((mir_tfunc_t)ol_tree_1, (void*)&imm_args_1, sizeof(data_env_1_t), 0, NULL, "ol_tree_1");
+    }
+
+    mir_task_wait();
+
+    uint64_t sum = 1;
+    for (int i = 0; i < width; i++)
+        sum += x[i];
+
+    return sum;
+} /*}}}*/
+
+static uint64_t tree_serial(int depth, int width)
+{ /*{{{*/
+    if (depth == 0)
+        return 1;
+
+    uint64_t sum = 1;
+    for (int i = 0; i < width; i++)
+        sum += tree_serial(i == 0 ? depth - 1 : depth / 2, width);
+
+    return sum;
+} /*}}}*/
+
+START_TEST(wait_depth_fib)
+{/*{{{*/
+    mir_create();
+
+    uint64_t result = fib(22);
+
+    mir_destroy();
+
+    ck_assert_int_eq(result, 17711);
+}/*}}}*/
+END_TEST
+
+START_TEST(wait_depth_unbalanced)
+{/*{{{*/
+    mir_create();
+
+    uint64_t result = tree(12, 4);
+
+    mir_destroy();
+
+    ck_assert_int_eq(result, tree_serial(12, 4));
+}/*}}}*/
+END_TEST
+
+Suite* test_suite(void)
+{/*{{{*/
+    Suite* s;
+    s = suite_create("Test");
+
+    TCase* tc = tcase_create("wait_depth");
+    tcase_add_test(tc, wait_depth_fib);
+    tcase_add_test(tc, wait_depth_unbalanced);
+    tcase_set_timeout(tc, 10);
+    suite_add_tcase(s, tc);
+
+    return s;
+}/*}}}*/
+
+int main(void)
+{/*{{{*/
+    int number_failed;
+    Suite* s;
+    SRunner* sr;
+
+    s = test_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_VERBOSE);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}/*}}}*/